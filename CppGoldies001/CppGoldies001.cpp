@@ -10,9 +10,11 @@
  */
 /*__________________________________________________________________________*/
 
+#include <cstddef>
 #include <cstdint>
-#include <deque>
+#include <vector>
 #include <iostream>
+#include <stdexcept>
 //#define __DBG_SERIALIZER
 #ifdef __DBG_SERIALIZER
 //! DBGOUT only enable during development
@@ -79,24 +81,50 @@ namespace Serializer
 		const std::uint8_t version() { return 1; };
 	};
 	//------------------------------------------------------
+	/*
+		Read-only view of a contiguous range of bytes
+		(pointer + length). The view never owns, mutates
+		or frees the memory it refers to.
+	*/
+	//------------------------------------------------------
+	class ByteView
+	{
+	public:
+		ByteView() : _data(nullptr), _size(0) {}
+		ByteView(const std::uint8_t *data, std::size_t size) : _data(data), _size(size) {}
+		ByteView(const std::vector<std::uint8_t> &buf) : _data(buf.data()), _size(buf.size()) {}
+		const std::uint8_t *data() const { return _data; }
+		std::size_t size() const { return _size; }
+		bool empty() const { return 0 == _size; }
+		const std::uint8_t *begin() const { return _data; }
+		const std::uint8_t *end() const { return _data + _size; }
+
+	private:
+		const std::uint8_t *_data;
+		std::size_t _size;
+	};
+	//------------------------------------------------------
 	/*
 		Is responsible for serializing a class into the
 		streaming buffer.
-		This class implements the templatemethods defined by 
+		This class implements the templatemethods defined by
 		IStream.
+		The buffer is one contiguous block, so getbuffer()
+		can be handed directly to write()/send().
 	*/
 	//------------------------------------------------------
 	class OutStream : public IStream
 	{
 	public:
-		typedef std::deque<std::uint8_t> t_buffer;
+		typedef std::vector<std::uint8_t> t_buffer;
 
 	private:
 		// implement interface IStream
 		IStream &marshal(std::uint8_t &v) override
 		{
-			_buffer.push_back(TV::unsignedByte);
-			_buffer.push_back(v);
+			auto p = claim(2);
+			p[0] = TV::unsignedByte;
+			p[1] = v;
 			return *this;
 		};
 		IStream &marshal(ISerializable &C) override
@@ -104,11 +132,24 @@ namespace Serializer
 			C.serialize(*this);
 			return *this;
 		};
+		/* grow the buffer by n bytes and return where to write them */
+		std::uint8_t *claim(std::size_t n)
+		{
+			auto used = _buffer.size();
+			_buffer.resize(used + n);
+			return _buffer.data() + used;
+		}
 		// local vars
 		t_buffer _buffer;
 
 	public:
 		t_buffer &getbuffer() { return _buffer; }
+		const std::uint8_t *data() const { return _buffer.data(); }
+		std::size_t size() const { return _buffer.size(); }
+		ByteView view() const { return ByteView(_buffer); }
+		/* presize the buffer, avoids reallocation while serializing */
+		void reserve(std::size_t n) { _buffer.reserve(n); }
+		/* empties the buffer but keeps the allocated capacity */
 		void reset() { _buffer.clear(); }
 	};
 	//------------------------------------------------------
@@ -117,25 +158,25 @@ namespace Serializer
 		streaming buffer.
 		This class implements the templatemethods defined by
 		IStream.
+		The stream is a read cursor over a contiguous range
+		owned by the caller, decoding never mutates or frees
+		the source, so the range must outlive the decoding.
 	*/
 	//------------------------------------------------------
 	class InStream : public IStream
 	{
 	public:
-		typedef std::deque<std::uint8_t> t_buffer;
+		typedef std::vector<std::uint8_t> t_buffer;
 
 	private:
 		// implement interface IStream
 		IStream &marshal(std::uint8_t &v) override
 		{
-			if (_buffer.front() == TV::unsignedByte)
-			{
-				_buffer.pop_front();
-				v = _buffer.front();
-				_buffer.pop_front();
-			}
-			else
+			need(2);
+			if (_cursor[0] != TV::unsignedByte)
 				throw std::invalid_argument("unknown datatype in TV processing");
+			v = _cursor[1];
+			_cursor += 2;
 			return *this;
 		};
 		IStream &marshal(ISerializable &C) override
@@ -143,11 +184,33 @@ namespace Serializer
 			C.serialize(*this);
 			return *this;
 		};
+		/* throws if less than n bytes are left to read */
+		void need(std::size_t n) const
+		{
+			if (remaining() < n)
+				throw std::runtime_error("read beyond end of buffer in InStream");
+		}
 		// local vars
-		t_buffer &_buffer;
+		const std::uint8_t *_begin;
+		const std::uint8_t *_cursor;
+		const std::uint8_t *_end;
 
 	public:
-		InStream(t_buffer &buf) : _buffer(buf) {}
+		InStream() : _begin(nullptr), _cursor(nullptr), _end(nullptr) {}
+		InStream(ByteView buf) { setBuffer(buf); }
+		InStream(const t_buffer &buf) { setBuffer(buf); }
+		// a temporary buffer would be gone before it's decoded
+		InStream(t_buffer &&) = delete;
+		void setBuffer(ByteView buf)
+		{
+			_begin = _cursor = buf.data();
+			_end = buf.data() + buf.size();
+		}
+		void setBuffer(const t_buffer &buf) { setBuffer(ByteView(buf)); }
+		void setBuffer(t_buffer &&) = delete;
+		/* start reading from the beginning of the range again */
+		void rewind() { _cursor = _begin; }
+		std::size_t remaining() const { return static_cast<std::size_t>(_end - _cursor); }
 	};
 } // namespace Serializer
 //------------------------------------------------------
@@ -11,10 +11,54 @@
 /*__________________________________________________________________________*/
 
 #include <stdio.h>
+#include <cstdlib>
+#include <chrono>
+#include <string>
+#include <cstddef>
 #include <cstdint>
-#include <deque>
+#include <cstring>
+#include <vector>
 #include <map>
+#include <unordered_map>
+#include <array>
+#include <tuple>
+#include <utility>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <new>
+#include <memory>
 #include <iostream>
+#include <stdexcept>
+#include <limits>
+#include <algorithm>
+#include <type_traits>
+#include <exception>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <climits>
+#include <cerrno>
+#endif
+#if defined(__cpp_impl_coroutine) && defined(__linux__)
+#include <coroutine>
+#include <unordered_set>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
 
 //#define __DBG_SERIALIZER
 #ifdef __DBG_SERIALIZER
@@ -25,11 +69,22 @@
 #define DBGOUT(txt)
 #endif
 
+//#define GOLDIES_METRICS
+#ifdef GOLDIES_METRICS
+//! METRIC hooks the Metrics package into the hot path
+#define METRIC(stmt) stmt
+#else
+//! METRIC compiles to nothing without GOLDIES_METRICS
+#define METRIC(stmt)
+#endif
+
 /* Serializer package */
 namespace Serializer
 {
 	// forward declaration of IStream, because it's needed in ISerializable
 	class IStream;
+	// forward declaration of ByteView, a field type of its own
+	class ByteView;
 	//------------------------------------------------------
 	/*
 		Enum wrapper class, removes the enum definition from
@@ -43,357 +98,5050 @@ namespace Serializer
 		{
 			unsignedByte,
 			ISerializable,
-			Classidentifier
+			Classidentifier,
+			boolean,
+			signedByte,
+			unsignedShort,
+			signedShort,
+			unsignedInt,
+			signedInt,
+			unsignedLong,
+			signedLong,
+			singleFloat,
+			doubleFloat,
+			sequence
 		};
 	};
 	//------------------------------------------------------
 	/*
-		Defines interface for all subjects that're going to
-		be serialized.
+		Maps a primitive type onto its TV tag at compile
+		time, only the supported primitives are defined.
 	*/
 	//------------------------------------------------------
-	class ISerializable
+	template <typename T>
+	struct TypeTag;
+	template <>
+	struct TypeTag<bool> { static const TV::types value = TV::boolean; };
+	template <>
+	struct TypeTag<std::uint8_t> { static const TV::types value = TV::unsignedByte; };
+	template <>
+	struct TypeTag<std::int8_t> { static const TV::types value = TV::signedByte; };
+	template <>
+	struct TypeTag<std::uint16_t> { static const TV::types value = TV::unsignedShort; };
+	template <>
+	struct TypeTag<std::int16_t> { static const TV::types value = TV::signedShort; };
+	template <>
+	struct TypeTag<std::uint32_t> { static const TV::types value = TV::unsignedInt; };
+	template <>
+	struct TypeTag<std::int32_t> { static const TV::types value = TV::signedInt; };
+	template <>
+	struct TypeTag<std::uint64_t> { static const TV::types value = TV::unsignedLong; };
+	template <>
+	struct TypeTag<std::int64_t> { static const TV::types value = TV::signedLong; };
+	template <>
+	struct TypeTag<float> { static const TV::types value = TV::singleFloat; };
+	template <>
+	struct TypeTag<double> { static const TV::types value = TV::doubleFloat; };
+	/* true for the types TypeTag knows, they're marshalled as values */
+	template <typename T, typename = void>
+	struct IsPrimitive : std::false_type
+	{
+	};
+	template <typename T>
+	struct IsPrimitive<T, decltype(void(TypeTag<T>::value))> : std::true_type
+	{
+	};
+	/* the standard containers the streams handle, see transfer() */
+	template <typename T>
+	struct IsContainer : std::false_type
+	{
+	};
+	template <typename T, typename A>
+	struct IsContainer<std::vector<T, A>> : std::true_type
+	{
+	};
+	// vector<bool> has no addressable elements
+	template <typename A>
+	struct IsContainer<std::vector<bool, A>> : std::false_type
+	{
+	};
+	template <typename Traits, typename A>
+	struct IsContainer<std::basic_string<char, Traits, A>> : std::true_type
+	{
+	};
+	template <typename T, std::size_t N>
+	struct IsContainer<std::array<T, N>> : std::true_type
+	{
+	};
+	template <typename K, typename V, typename C, typename A>
+	struct IsContainer<std::map<K, V, C, A>> : std::true_type
+	{
+	};
+	template <typename K, typename V, typename H, typename E, typename A>
+	struct IsContainer<std::unordered_map<K, V, H, E, A>> : std::true_type
+	{
+	};
+	// views go on the wire like the containers they refer to
+	template <>
+	struct IsContainer<ByteView> : std::true_type
+	{
+	};
+#ifdef __cpp_lib_string_view
+	template <>
+	struct IsContainer<std::string_view> : std::true_type
+	{
+	};
+#endif
+	/* element types copied as one block: the primitives but bool, and char for strings */
+	template <typename T, typename = void>
+	struct BlockTag;
+	template <typename T>
+	struct BlockTag<T, typename std::enable_if<IsPrimitive<T>::value && !std::is_same<T, bool>::value>::type>
+	{
+		static const TV::types value = TypeTag<T>::value;
+	};
+	template <>
+	struct BlockTag<char> { static const TV::types value = TV::unsignedByte; };
+	template <typename T, typename = void>
+	struct IsBlock : std::false_type
+	{
+	};
+	template <typename T>
+	struct IsBlock<T, decltype(void(BlockTag<T>::value))> : std::true_type
+	{
+	};
+	template <typename... Ts>
+	struct Fields;
+	/* bytes a T takes on the wire at least, in any wire format: varints shrink integers
+	   to a byte, a container is at least its length, an object may take none unless it
+	   lists its fields (see FixedSize) */
+	template <typename T, typename = void>
+	struct LeastSize : std::integral_constant<std::size_t, IsPrimitive<T>::value ? (std::is_integral<T>::value ? 1 : sizeof(T)) : IsContainer<T>::value ? 1 : 0>
+	{
+	};
+	template <>
+	struct LeastSize<Fields<>> : std::integral_constant<std::size_t, 0>
+	{
+	};
+	template <typename T, typename... Ts>
+	struct LeastSize<Fields<T, Ts...>> : std::integral_constant<std::size_t, LeastSize<T>::value + LeastSize<Fields<Ts...>>::value>
+	{
+	};
+	template <typename T>
+	struct LeastSize<T, decltype(void(sizeof(typename T::fields)))> : LeastSize<typename T::fields>
+	{
+	};
+	/* the same for a container element, block elements are fixed width in every format */
+	template <typename T>
+	struct ElementSize : std::integral_constant<std::size_t, IsBlock<T>::value ? sizeof(T) : LeastSize<T>::value>
+	{
+	};
+	/* how the static operator& of a stream handles a T */
+	typedef std::integral_constant<int, 0> primitiveKind;
+	typedef std::integral_constant<int, 1> containerKind;
+	typedef std::integral_constant<int, 2> objectKind;
+	template <typename T>
+	struct Kind : std::integral_constant<int, IsPrimitive<T>::value ? 0 : IsContainer<T>::value ? 1 : 2>
 	{
-	public:
-		ISerializable() {}
-		virtual ~ISerializable() {}
-		virtual void serialize(IStream &s) = 0;
 	};
 	//------------------------------------------------------
 	/*
-		Defines an interface for both input and output streams.
-		The relation between the IStream and the descantents are
-		implemented by means of the Template method pattern [GOF]
-		https://en.wikipedia.org/wiki/Template_method_pattern
+		The wire layout of every primitive is little-endian.
+		On little-endian hosts a value is stored/loaded with
+		a single memcpy, big-endian hosts byte swap on top.
+		bool goes on the wire as one byte, 0 or 1.
 	*/
 	//------------------------------------------------------
-	class IStream
+	class LittleEndian
 	{
-	private:
-		virtual IStream &marshal(std::uint8_t &) = 0;
-		virtual IStream &marshal(ISerializable &) = 0;
-
 	public:
 		template <typename T>
-		inline IStream &operator&(T &t)
+		static void store(std::uint8_t *p, T v)
 		{
-			DBGOUT("IStream& operator&(T& t)");
-			return marshal(t);
+			typename Unsigned<sizeof(T)>::type u;
+			std::memcpy(&u, &v, sizeof(T));
+			u = toWire(u);
+			std::memcpy(p, &u, sizeof(T));
+		}
+		static void store(std::uint8_t *p, bool v) { *p = v ? 1 : 0; }
+		/* true if elements of size bytes are laid out in memory as on the wire */
+		static bool native(std::size_t size)
+		{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+			return 1 == size;
+#else
+			return 0 < size;
+#endif
+		}
+		/* count elements of size bytes from src to dst, in either direction */
+		static void copy(void *dst, const void *src, std::size_t count, std::size_t size)
+		{
+			if (0 == count)
+				return;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+			auto d = static_cast<std::uint8_t *>(dst);
+			auto s = static_cast<const std::uint8_t *>(src);
+			for (std::size_t e = 0; e < count; ++e, d += size, s += size)
+				for (std::size_t i = 0; i < size; ++i)
+					d[i] = s[size - 1 - i];
+#else
+			std::memcpy(dst, src, count * size);
+#endif
+		}
+		template <typename T>
+		static T load(const std::uint8_t *p)
+		{
+			typename Unsigned<sizeof(T)>::type u;
+			std::memcpy(&u, p, sizeof(T));
+			u = toWire(u);
+			T v;
+			std::memcpy(&v, &u, sizeof(T));
+			return v;
+		}
+
+	private:
+		template <std::size_t N>
+		struct Unsigned;
+		template <typename U>
+		static U toWire(U u)
+		{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+			U r = 0;
+			for (std::size_t i = 0; i < sizeof(U); ++i, u >>= 8)
+				r = static_cast<U>((r << 8) | (u & 0xFF));
+			return r;
+#else
+			return u;
+#endif
 		}
-		const std::uint8_t version() { return 1; };
 	};
+	template <>
+	struct LittleEndian::Unsigned<1> { typedef std::uint8_t type; };
+	template <>
+	struct LittleEndian::Unsigned<2> { typedef std::uint16_t type; };
+	template <>
+	struct LittleEndian::Unsigned<4> { typedef std::uint32_t type; };
+	template <>
+	struct LittleEndian::Unsigned<8> { typedef std::uint64_t type; };
+	template <>
+	inline bool LittleEndian::load<bool>(const std::uint8_t *p) { return 0 != *p; }
 	//------------------------------------------------------
 	/*
-		Is responsible for serializing a class into the
-		streaming buffer.
-		This class implements the templatemethods defined by
-		IStream.
+		Describes how values go on the wire.
+		tagged:  every value is preceded by its TV tag, the
+		         stream is self-describing.
+		compact: only payload bytes, the schema is implied by
+		         the order of the serialize() method. Optionally
+		         a schema hash is checked once per message.
+		Independent of the layout integers wider than a byte
+		can be sent as fixed width little-endian values or as
+		LEB128 varints (zigzag for signed types).
+		Both sides of the wire have to agree on the format.
 	*/
 	//------------------------------------------------------
-	class OutStream : public IStream
+	class WireFormat
 	{
 	public:
-		typedef std::deque<std::uint8_t> t_buffer;
-
-	private:
-		// implement interface IStream
-		IStream &marshal(std::uint8_t &v) override
+		enum layouts : std::uint8_t
 		{
-			_buffer.push_back(TV::unsignedByte);
-			_buffer.push_back(v);
-			return *this;
+			tagged,
+			compact
 		};
-		IStream &marshal(ISerializable &C) override
+		enum integers : std::uint8_t
 		{
-			C.serialize(*this);
-			return *this;
+			fixed,
+			varint
 		};
-		// local vars
-		t_buffer _buffer;
+		WireFormat(layouts layout = tagged) : _layout(layout), _integers(fixed), _schemaCheck(false), _lengthPrefix(false) {}
+		layouts layout() const { return _layout; }
+		bool isTagged() const { return tagged == _layout; }
+		bool hasVarints() const { return varint == _integers; }
+		bool schemaCheck() const { return _schemaCheck; }
+		bool hasLengthPrefix() const { return _lengthPrefix; }
+		/* true if both produce the same bytes for the same subject */
+		bool sameEncoding(const WireFormat &other) const
+		{
+			return _layout == other._layout && _integers == other._integers && _lengthPrefix == other._lengthPrefix;
+		}
+		WireFormat &withSchemaCheck(bool on = true)
+		{
+			_schemaCheck = on;
+			return *this;
+		}
+		WireFormat &withVarints(bool on = true)
+		{
+			_integers = on ? varint : fixed;
+			return *this;
+		}
+		/* every nested object gets a [tag +] u32 length in front, so it can be skipped or decoded lazily */
+		WireFormat &withLengthPrefix(bool on = true)
+		{
+			_lengthPrefix = on;
+			return *this;
+		}
 
-	public:
-		t_buffer &getbuffer() { return _buffer; }
-		void reset() { _buffer.clear(); }
+	private:
+		layouts _layout;
+		integers _integers;
+		bool _schemaCheck;
+		bool _lengthPrefix;
 	};
 	//------------------------------------------------------
 	/*
-		Is responsible for deserializing a class into the
-		streaming buffer.
-		This class implements the templatemethods defined by
-		IStream.
+		LEB128 varint coding, 7 bits per byte, the high bit
+		flags that more bytes follow. Signed values are
+		zigzag mapped first, so small negative numbers stay
+		short as well. The decoder has a fast path that
+		handles up to 8 bytes in one step without a loop.
 	*/
 	//------------------------------------------------------
-	class InStream : public IStream
+	class Varint
 	{
 	public:
-		typedef std::deque<std::uint8_t> t_buffer;
-
-	private:
-		// implement interface IStream
-		IStream &marshal(std::uint8_t &v) override
+		static const std::size_t maxBytes = 10;
+		/* integers wider than a byte are the ones worth a varint */
+		template <typename T>
+		struct applies : std::integral_constant<bool, std::is_integral<T>::value && (sizeof(T) > 1)>
+		{
+		};
+		template <typename T>
+		static std::uint64_t toUnsigned(T v)
+		{
+			return toUnsigned(v, std::is_signed<T>());
+		}
+		/* narrows a decoded value back into T, throws if it doesn't fit */
+		template <typename T>
+		static T fromUnsigned(std::uint64_t u)
+		{
+			return fromUnsigned<T>(u, std::is_signed<T>());
+		}
+		/* number of bytes v takes on the wire */
+		static std::size_t size(std::uint64_t v)
+		{
+			return 1 + (63 - countLeadingZeros(v | 1)) / 7;
+		}
+		/* writes v into p, which must have room for size(v) bytes */
+		static std::size_t encode(std::uint8_t *p, std::uint64_t v)
+		{
+			auto n = size(v);
+			for (std::size_t i = 0; i + 1 < n; ++i, v >>= 7)
+				p[i] = static_cast<std::uint8_t>(v | 0x80);
+			p[n - 1] = static_cast<std::uint8_t>(v);
+			return n;
+		}
+		/* reads a varint from [p, end), returns the bytes consumed or 0 if it's truncated or overlong */
+		static std::size_t decode(const std::uint8_t *p, const std::uint8_t *end, std::uint64_t &v)
 		{
-			if (_buffer.front() == TV::unsignedByte)
+			if (end - p >= 8)
 			{
-				_buffer.pop_front();
-				v = _buffer.front();
-				_buffer.pop_front();
+				auto w = LittleEndian::load<std::uint64_t>(p);
+				auto stops = ~w & 0x8080808080808080ull;
+				if (0 != stops)
+				{
+					// keep the bytes up to and including the first one without continuation bit
+					auto lowest = stops & (0 - stops);
+					w &= ((lowest << 1) - 1) & 0x7F7F7F7F7F7F7F7Full;
+					// squeeze the 7 bit groups together, pairs, quads and then the two halves
+					w = (w & 0x007F007F007F007Full) | ((w & 0x7F007F007F007F00ull) >> 1);
+					w = (w & 0x00003FFF00003FFFull) | ((w & 0x3FFF00003FFF0000ull) >> 2);
+					w = (w & 0x000000000FFFFFFFull) | ((w & 0x0FFFFFFF00000000ull) >> 4);
+					v = w;
+					return (countTrailingZeros(stops) >> 3) + 1;
+				}
 			}
-			else
-				throw std::runtime_error("unknown datatype in TV processing");
-			return *this;
-		};
-		IStream &marshal(ISerializable &C) override
+			v = 0;
+			for (std::size_t n = 0, shift = 0; p + n < end && n < maxBytes; shift += 7)
+			{
+				auto b = p[n++];
+				// the 10th byte holds bit 63 only, more would be shifted out
+				if (maxBytes == n && b > 1)
+					return 0;
+				v |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+				if (0 == (b & 0x80))
+					return n;
+			}
+			return 0;
+		}
+		/* bit scans, v must not be 0 */
+		static unsigned countLeadingZeros(std::uint64_t v)
 		{
-			C.serialize(*this);
-			return *this;
-		};
-		// local vars
-		t_buffer _buffer;
+#if defined(_MSC_VER)
+			unsigned long i;
+			_BitScanReverse64(&i, v);
+			return 63 - i;
+#else
+			return __builtin_clzll(v);
+#endif
+		}
+		static unsigned countTrailingZeros(std::uint64_t v)
+		{
+#if defined(_MSC_VER)
+			unsigned long i;
+			_BitScanForward64(&i, v);
+			return i;
+#else
+			return __builtin_ctzll(v);
+#endif
+		}
 
-	public:
-		InStream() {}
-		InStream(t_buffer &buf) : _buffer(buf) {}
-		void setBuffer(t_buffer &buf) { _buffer = buf; }
-		std::uint8_t peek()
+	private:
+		static std::uint64_t toUnsigned(std::int64_t v, std::true_type)
+		{
+			return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+		}
+		static std::uint64_t toUnsigned(std::uint64_t v, std::false_type) { return v; }
+		template <typename T>
+		static T fromUnsigned(std::uint64_t u, std::true_type)
+		{
+			auto v = static_cast<std::int64_t>(u >> 1) ^ -static_cast<std::int64_t>(u & 1);
+			if (v < std::numeric_limits<T>::min() || v > std::numeric_limits<T>::max())
+				throw std::runtime_error("varint out of range in InStream");
+			return static_cast<T>(v);
+		}
+		template <typename T>
+		static T fromUnsigned(std::uint64_t u, std::false_type)
 		{
-			auto iter = _buffer.begin();
-			return *++iter; //might assert/throw if not checked...
+			if (u > std::numeric_limits<T>::max())
+				throw std::runtime_error("varint out of range in InStream");
+			return static_cast<T>(u);
 		}
 	};
-} // namespace Serializer
-/* 
-	Construction package implements 
-	Factory	Method Pattern [GOF]
-	https://en.wikipedia.org/wiki/Factory_method_pattern
-	But only the generic parts, the rest is implemented by
-	the client SW that utilizes this package.
-*/
-namespace Construction
-{
 	//------------------------------------------------------
 	/*
-	This class plays the role as Creator in the 
-	Factory	Method Pattern 
+		Defines interface for all subjects that're going to
+		be serialized.
 	*/
 	//------------------------------------------------------
-	template <typename product>
-	class IProduce
+	class ISerializable
 	{
 	public:
-		typedef product *productPtr;
-		virtual productPtr Create() = 0;
+		ISerializable() {}
+		virtual ~ISerializable() {}
+		virtual void serialize(IStream &s) = 0;
 	};
 	//------------------------------------------------------
 	/*
-	This Class plays the role as the factory, which actually
-	holds the factory method of Factory	Method Pattern [GOF]
+		Static dispatch flavour of ISerializable (CRTP).
+		The subject implements serialize() as a member
+		template over the stream type:
+			template <typename Stream>
+			void serialize(Stream &s) { s &_a &_b; }
+		Called with a concrete OutStream/InStream everything
+		inlines, no virtual calls at all. Called through
+		ISerializable/IStream it falls back to the virtual
+		interface, so runtime polymorphism still works.
 	*/
 	//------------------------------------------------------
-	template <typename product, typename productTag>
-	class Factory
+	template <typename Derived>
+	class Serializable : public ISerializable
 	{
-	private:
-		typedef IProduce<product> *Producer;
-		typedef typename IProduce<product>::productPtr productPtr;
-		typedef std::map<productTag, Producer> manufacturingLines;
-		manufacturingLines _manufacturingLines;
-
 	public:
-		/* Order a specific object from the factory */
-		productPtr fabricate(productTag id)
-		{
-			auto iter = _manufacturingLines.find(id);
-			if (iter != _manufacturingLines.end())
-			{
-				if (nullptr == iter->second)
-					throw std::runtime_error("null ptr detected in fabricate(productTag id)...");
-				return iter->second->Create();
-			}
-			return nullptr;
-		}
-		/* install a concrete Creator in the factory */
-		void install(productTag id, Producer P)
+		void serialize(IStream &s) override
 		{
-			_manufacturingLines[id] = P;
+			static_cast<Derived &>(*this).serialize(s);
 		}
 	};
-} // namespace Construction
-/* Messaging package */
-namespace Messaging
-{
-	//------------------------------------------------------
-	/*
-	Enum wrapper to protect the Messaging name space
-	*/
-	//------------------------------------------------------
-	class MessageIds
-	{
-	public:
-		enum type
-		{
-			msg001,
-			msg002
-		};
-		static std::uint8_t toUint(type v) { return v; }
-	};
 	//------------------------------------------------------
 	/*
-	Message class that holds a msg id and a payload, 
-	The payload can be any serializable.
+		Defines an interface for both input and output streams.
+		The relation between the IStream and the descantents are
+		implemented by means of the Template method pattern [GOF]
+		https://en.wikipedia.org/wiki/Template_method_pattern
 	*/
 	//------------------------------------------------------
-	class Message : public Serializer::ISerializable
+	class IStream
 	{
-		MessageIds::type _id;
-		Serializer::ISerializable *_payload;
+	private:
+		virtual IStream &marshal(bool &) = 0;
+		virtual IStream &marshal(std::uint8_t &) = 0;
+		virtual IStream &marshal(std::int8_t &) = 0;
+		virtual IStream &marshal(std::uint16_t &) = 0;
+		virtual IStream &marshal(std::int16_t &) = 0;
+		virtual IStream &marshal(std::uint32_t &) = 0;
+		virtual IStream &marshal(std::int32_t &) = 0;
+		virtual IStream &marshal(std::uint64_t &) = 0;
+		virtual IStream &marshal(std::int64_t &) = 0;
+		virtual IStream &marshal(float &) = 0;
+		virtual IStream &marshal(double &) = 0;
+		virtual IStream &marshal(ISerializable &) = 0;
+
+		template <typename T>
+		IStream &route(T &t, std::false_type) { return marshal(t); }
+		template <typename T>
+		IStream &route(T &t, std::true_type);
 
 	public:
-		Message(MessageIds::type id, Serializer::ISerializable *payload) : _id(id), _payload(payload) {}
-		void serialize(Serializer::IStream &s)
+		template <typename T>
+		inline IStream &operator&(T &t)
 		{
-			auto id = MessageIds::toUint(_id);
-			s &id &*_payload;
+			DBGOUT("IStream& operator&(T& t)");
+			return route(t, IsContainer<T>());
 		}
-		Serializer::ISerializable &getPayload()
+		const std::uint8_t version() { return 1; };
+		const WireFormat &wireFormat() const { return _wireFormat; }
+		/* what the stream does to the subject, containers need to know */
+		enum modes
 		{
-			if (nullptr == _payload)
-				throw std::runtime_error("nullptr in message getpayload()");
-			return *_payload;
-		}
+			encoding,
+			decoding,
+			describing
+		};
+		virtual modes mode() const = 0;
+		/* container length, written as given or read back, returns the length to use,
+		   every element takes at least least bytes, 0 if it can take none */
+		virtual std::size_t sequence(std::size_t n, std::size_t least) = 0;
+		/* count elements of size bytes each as one block, tag is the element type */
+		virtual void block(void *elements, std::size_t count, std::size_t size, std::uint8_t tag) = 0;
+		/* a view field, bytes like a std::string, decoding points it into the source */
+		virtual void bytes(ByteView &v);
+		/* a nested object kept as its encoded bytes (Lazy), encoding writes v as it is
+		   when format is this stream's encoding, decoding points v at the object's bytes.
+		   false if the stream can't, the object is transferred field by field then */
+		virtual bool verbatim(ByteView &, const WireFormat &) { return false; }
+
+	protected:
+		IStream(WireFormat wireFormat = WireFormat()) : _wireFormat(wireFormat) {}
+		~IStream() {}
+		WireFormat _wireFormat;
 	};
 	//------------------------------------------------------
 	/*
-	Send class is able to sent a message surprisingly enough
+		Standard containers, found by operator& of every
+		stream. A container is its length, then the elements.
+		Elements of BlockTag types go as one block copy of
+		fixed width little-endian values (also with varints),
+		in the tagged layout with one tag for the whole block,
+		other elements one by one with their own operator&.
+		Decoding resizes the target: existing elements and
+		capacity are reused, so decoding into the same object
+		again doesn't allocate unless it has to grow. Map
+		nodes are recycled where node extraction exists.
+		Describing (schema hashing) visits one element.
 	*/
 	//------------------------------------------------------
-	class Send
+	template <typename Stream, typename T>
+	void elements(Stream &s, T *first, std::size_t n, std::true_type)
 	{
-	public:
-		/* convert message to byte stream */
-		Serializer::OutStream::t_buffer &package(Message &msg)
+		s.block(first, n, sizeof(T), BlockTag<T>::value);
+	}
+	template <typename Stream, typename T>
+	void elements(Stream &s, T *first, std::size_t n, std::false_type)
+	{
+		if (IStream::describing == s.mode())
 		{
-			msg.serialize(_toOutput);
-			return _toOutput.getbuffer();
+			T element{};
+			s &element;
+			return;
+		}
+		for (std::size_t i = 0; i < n; ++i)
+			s &first[i];
+	}
+	template <typename Stream, typename T, typename A>
+	void transfer(Stream &s, std::vector<T, A> &v)
+	{
+		v.resize(s.sequence(v.size(), ElementSize<T>::value));
+		elements(s, v.data(), v.size(), IsBlock<T>());
+	}
+	template <typename Stream, typename Traits, typename A>
+	void transfer(Stream &s, std::basic_string<char, Traits, A> &v)
+	{
+		v.resize(s.sequence(v.size(), 1));
+		elements(s, v.empty() ? nullptr : &v[0], v.size(), std::true_type());
+	}
+	template <typename Stream, typename T, std::size_t N>
+	void transfer(Stream &s, std::array<T, N> &v)
+	{
+		if (N != s.sequence(N, ElementSize<T>::value))
+			throw std::runtime_error("length doesn't match the std::array");
+		elements(s, v.data(), N, IsBlock<T>());
+	}
+	template <typename Stream, typename Map>
+	void entries(Stream &s, Map &m)
+	{
+		auto n = s.sequence(m.size(), LeastSize<typename Map::key_type>::value + LeastSize<typename Map::mapped_type>::value);
+		if (IStream::describing == s.mode())
+		{
+			typename Map::key_type key{};
+			typename Map::mapped_type value{};
+			s &key &value;
+			return;
+		}
+		if (IStream::encoding == s.mode())
+		{
+			// encoding streams only read the key
+			for (auto &entry : m)
+				s &const_cast<typename Map::key_type &>(entry.first) & entry.second;
+			return;
+		}
+		Map old(std::move(m));
+		m.clear();
+		for (std::size_t i = 0; i < n; ++i)
+		{
+#ifdef __cpp_lib_node_extract
+			if (!old.empty())
+			{
+				auto node = old.extract(old.begin());
+				s &node.key() & node.mapped();
+				m.insert(std::move(node));
+				continue;
+			}
+#endif
+			typename Map::key_type key{};
+			typename Map::mapped_type value{};
+			s &key &value;
+			m.emplace(std::move(key), std::move(value));
+		}
+	}
+	template <typename Stream, typename K, typename V, typename C, typename A>
+	void transfer(Stream &s, std::map<K, V, C, A> &m)
+	{
+		entries(s, m);
+	}
+	template <typename Stream, typename K, typename V, typename H, typename E, typename A>
+	void transfer(Stream &s, std::unordered_map<K, V, H, E, A> &m)
+	{
+		entries(s, m);
+	}
+	template <typename T>
+	IStream &IStream::route(T &t, std::true_type)
+	{
+		transfer(*this, t);
+		return *this;
+	}
+	//------------------------------------------------------
+	/*
+		Read-only view of a contiguous range of bytes
+		(pointer + length). The view never owns, mutates
+		or frees the memory it refers to.
+	*/
+	//------------------------------------------------------
+	class ByteView
+	{
+	public:
+		ByteView() : _data(nullptr), _size(0) {}
+		ByteView(const std::uint8_t *data, std::size_t size) : _data(data), _size(size) {}
+		ByteView(const std::vector<std::uint8_t> &buf) : _data(buf.data()), _size(buf.size()) {}
+		const std::uint8_t *data() const { return _data; }
+		std::size_t size() const { return _size; }
+		bool empty() const { return 0 == _size; }
+		const std::uint8_t *begin() const { return _data; }
+		const std::uint8_t *end() const { return _data + _size; }
+
+	private:
+		const std::uint8_t *_data;
+		std::size_t _size;
+	};
+	inline void IStream::bytes(ByteView &v)
+	{
+		sequence(v.size(), 1);
+		block(const_cast<std::uint8_t *>(v.data()), v.size(), 1, TV::unsignedByte);
+	}
+	//------------------------------------------------------
+	/*
+		View fields. A ByteView (or std::string_view) member
+		is serialized like a std::vector<std::uint8_t> (or
+		std::string), so either side may use the owning type
+		instead. Decoding doesn't copy, the view points into
+		the range the InStream reads from and is only valid
+		as long as that range is: copy the bytes out or
+		re-serialize the subject before the buffer is reused.
+	*/
+	//------------------------------------------------------
+	template <typename Stream>
+	void transfer(Stream &s, ByteView &v)
+	{
+		s.bytes(v);
+	}
+#ifdef __cpp_lib_string_view
+	template <typename Stream>
+	void transfer(Stream &s, std::string_view &v)
+	{
+		ByteView text(reinterpret_cast<const std::uint8_t *>(v.data()), v.size());
+		s.bytes(text);
+		v = std::string_view(reinterpret_cast<const char *>(text.data()), text.size());
+	}
+#endif
+	//------------------------------------------------------
+	/*
+		Is responsible for serializing a class into the
+		streaming buffer.
+		This class implements the templatemethods defined by
+		IStream.
+		The buffer is one contiguous block, so getbuffer()
+		can be handed directly to write()/send().
+		With gatherAbove() the stream references big blocks
+		(containers of primitives, view fields) in place
+		instead of copying them, the output is then the list
+		of segments() for writev(): the own buffer holds the
+		small fields, coalesced between the references. The
+		referenced memory has to stay valid and unchanged
+		until the segments are written.
+	*/
+	//------------------------------------------------------
+	class OutStream : public IStream
+	{
+	public:
+		typedef std::vector<std::uint8_t> t_buffer;
+
+	private:
+		// implement interface IStream
+		IStream &marshal(bool &v) override { return put(v); }
+		IStream &marshal(std::uint8_t &v) override { return put(v); }
+		IStream &marshal(std::int8_t &v) override { return put(v); }
+		IStream &marshal(std::uint16_t &v) override { return put(v); }
+		IStream &marshal(std::int16_t &v) override { return put(v); }
+		IStream &marshal(std::uint32_t &v) override { return put(v); }
+		IStream &marshal(std::int32_t &v) override { return put(v); }
+		IStream &marshal(std::uint64_t &v) override { return put(v); }
+		IStream &marshal(std::int64_t &v) override { return put(v); }
+		IStream &marshal(float &v) override { return put(v); }
+		IStream &marshal(double &v) override { return put(v); }
+		IStream &marshal(ISerializable &C) override
+		{
+			nested(C);
+			return *this;
+		};
+		/* a nested object, length-prefixed if the wire format asks for it */
+		template <typename T>
+		void nested(T &t)
+		{
+			if (!_wireFormat.hasLengthPrefix())
+				return t.serialize(*this);
+			std::size_t tagged = _wireFormat.isTagged();
+			auto p = claim(tagged + sizeof(std::uint32_t));
+			if (tagged)
+				*p = TV::ISerializable;
+			// the buffer may move while t is written, so the length is patched by offset
+			auto at = written() - sizeof(std::uint32_t);
+			auto start = size();
+			t.serialize(*this);
+			auto length = size() - start;
+			if (length > std::numeric_limits<std::uint32_t>::max())
+				throw std::runtime_error("nested object too large for its length prefix in OutStream");
+			LittleEndian::store((nullptr != _attached ? _attached : _buffer.data()) + at, static_cast<std::uint32_t>(length));
+		}
+		template <typename T>
+		IStream &put(T v)
+		{
+			return put(v, Varint::applies<T>());
+		}
+		/* [tag +] varint, unless the stream uses fixed width integers */
+		template <typename T>
+		IStream &put(T v, std::true_type)
+		{
+			if (!_wireFormat.hasVarints())
+				return put(v, std::false_type());
+			std::size_t tagged = _wireFormat.isTagged();
+			auto u = Varint::toUnsigned(v);
+			auto p = claim(tagged + Varint::size(u));
+			if (tagged)
+				*p++ = TypeTag<T>::value;
+			Varint::encode(p, u);
+			return *this;
+		}
+		/* [tag +] value written as one block */
+		template <typename T>
+		IStream &put(T v, std::false_type)
+		{
+			std::size_t tagged = _wireFormat.isTagged();
+			auto p = claim(tagged + sizeof(T));
+			if (tagged)
+				*p++ = TypeTag<T>::value;
+			LittleEndian::store(p, v);
+			return *this;
+		}
+		/* bytes in the own buffer (or the attached memory) */
+		std::size_t written() const { return nullptr != _attached ? _written : _buffer.size(); }
+		/* n bytes at p become a segment of their own, after the bytes written so far */
+		void reference(const void *p, std::size_t n)
+		{
+			auto at = written();
+			if (at > _runStart)
+				_segments.push_back(Segment{nullptr, _runStart, at - _runStart});
+			_segments.push_back(Segment{static_cast<const std::uint8_t *>(p), 0, n});
+			_runStart = at;
+			_referenced += n;
+		}
+		/* a referenced block, or a run of the own buffer, which may still move */
+		struct Segment
+		{
+			const std::uint8_t *external;
+			std::size_t offset;
+			std::size_t size;
+		};
+		// local vars
+		t_buffer _buffer;
+		std::uint8_t *_attached;
+		std::size_t _capacity;
+		std::size_t _written;
+		std::size_t _gatherAbove;
+		std::size_t _referenced;
+		std::size_t _runStart;
+		std::vector<Segment> _segments;
+		std::vector<ByteView> _gathered;
+
+		template <typename T>
+		void store(T &t, primitiveKind) { put(t); }
+		template <typename T>
+		void store(T &t, containerKind) { transfer(*this, t); }
+		template <typename T>
+		void store(T &t, objectKind) { nested(t); }
+
+	public:
+		OutStream(WireFormat wireFormat = WireFormat())
+			: IStream(wireFormat), _attached(nullptr), _capacity(0), _written(0),
+			  _gatherAbove(std::numeric_limits<std::size_t>::max()), _referenced(0), _runStart(0) {}
+		/* static dispatch, hides IStream::operator& when the stream type is known */
+		template <typename T>
+		inline OutStream &operator&(T &t)
+		{
+			store(t, Kind<T>());
+			return *this;
+		}
+		modes mode() const override { return encoding; }
+		/* [tag +] length of a container, fixed width or varint */
+		std::size_t sequence(std::size_t n, std::size_t) override
+		{
+			if (n > std::numeric_limits<std::uint32_t>::max())
+				throw std::runtime_error("container too large in OutStream");
+			std::size_t tagged = _wireFormat.isTagged();
+			auto varint = _wireFormat.hasVarints();
+			auto p = claim(tagged + (varint ? Varint::size(n) : sizeof(std::uint32_t)));
+			if (tagged)
+				*p++ = TV::sequence;
+			if (varint)
+				Varint::encode(p, n);
+			else
+				LittleEndian::store(p, static_cast<std::uint32_t>(n));
+			return n;
+		}
+		/* [tag +] the elements as one copy, or referenced in place when gathering */
+		void block(void *elements, std::size_t count, std::size_t size, std::uint8_t tag) override
+		{
+			std::size_t tagged = _wireFormat.isTagged();
+			if (count * size >= _gatherAbove && LittleEndian::native(size))
+			{
+				if (tagged)
+					*claim(1) = tag;
+				reference(elements, count * size);
+				return;
+			}
+			auto p = claim(tagged + count * size);
+			if (tagged)
+				*p++ = tag;
+			LittleEndian::copy(p, elements, count, size);
+		}
+		/* the encoded bytes as they are, if they're in this stream's encoding */
+		bool verbatim(ByteView &v, const WireFormat &format) override
+		{
+			if (!format.sameEncoding(_wireFormat))
+				return false;
+			if (!v.empty())
+				std::memcpy(claim(v.size()), v.data(), v.size());
+			return true;
+		}
+		/* grow the buffer by n bytes and return where to write them, raw access for framing */
+		std::uint8_t *claim(std::size_t n)
+		{
+			if (nullptr != _attached)
+			{
+				if (_capacity - _written < n)
+					throw std::runtime_error("attached memory too small in OutStream");
+				auto p = _attached + _written;
+				_written += n;
+				return p;
+			}
+			auto used = _buffer.size();
+			_buffer.resize(used + n);
+			return _buffer.data() + used;
+		}
+		/* write into caller owned memory (a ring slot...) instead of the own buffer, until detach() */
+		void attach(std::uint8_t *p, std::size_t capacity)
+		{
+			_attached = p;
+			_capacity = capacity;
+			_written = 0;
+			_segments.clear();
+			_referenced = _runStart = 0;
+		}
+		void detach() { _attached = nullptr; }
+		/* the own bytes, without referenced blocks */
+		t_buffer &getbuffer() { return _buffer; }
+		const std::uint8_t *data() const { return nullptr != _attached ? _attached : _buffer.data(); }
+		/* bytes produced so far, referenced blocks included */
+		std::size_t size() const { return written() + _referenced; }
+		ByteView view() const { return ByteView(data(), written()); }
+		/* blocks of at least threshold bytes are referenced instead of copied, see segments() */
+		void gatherAbove(std::size_t threshold) { _gatherAbove = 0 < threshold ? threshold : 1; }
+		/* the output in order, valid until the stream is written to again */
+		const std::vector<ByteView> &segments()
+		{
+			_gathered.clear();
+			for (auto &segment : _segments)
+				_gathered.push_back(nullptr != segment.external ? ByteView(segment.external, segment.size) : ByteView(data() + segment.offset, segment.size));
+			if (written() > _runStart)
+				_gathered.push_back(ByteView(data() + _runStart, written() - _runStart));
+			return _gathered;
+		}
+		/* presize the buffer, avoids reallocation while serializing */
+		void reserve(std::size_t n) { _buffer.reserve(n); }
+		/* empties the buffer but keeps the allocated capacity */
+		void reset()
+		{
+			_buffer.clear();
+			_written = 0;
+			_segments.clear();
+			_referenced = _runStart = 0;
+		}
+	};
+	//------------------------------------------------------
+	/*
+		Is responsible for deserializing a class into the
+		streaming buffer.
+		This class implements the templatemethods defined by
+		IStream.
+		The stream is a read cursor over a contiguous range
+		owned by the caller, decoding never mutates or frees
+		the source, so the range must outlive the decoding,
+		and the view fields decoded from it.
+	*/
+	//------------------------------------------------------
+	class InStream : public IStream
+	{
+	public:
+		typedef std::vector<std::uint8_t> t_buffer;
+
+	private:
+		// implement interface IStream
+		IStream &marshal(bool &v) override { return get(v); }
+		IStream &marshal(std::uint8_t &v) override { return get(v); }
+		IStream &marshal(std::int8_t &v) override { return get(v); }
+		IStream &marshal(std::uint16_t &v) override { return get(v); }
+		IStream &marshal(std::int16_t &v) override { return get(v); }
+		IStream &marshal(std::uint32_t &v) override { return get(v); }
+		IStream &marshal(std::int32_t &v) override { return get(v); }
+		IStream &marshal(std::uint64_t &v) override { return get(v); }
+		IStream &marshal(std::int64_t &v) override { return get(v); }
+		IStream &marshal(float &v) override { return get(v); }
+		IStream &marshal(double &v) override { return get(v); }
+		IStream &marshal(ISerializable &C) override
+		{
+			nested(C);
+			return *this;
+		};
+		/* a nested object, when length-prefixed it's read within its bounds */
+		template <typename T>
+		void nested(T &t)
+		{
+			if (!_wireFormat.hasLengthPrefix())
+				return t.serialize(*this);
+			auto end = open();
+			auto outer = _end;
+			_end = end;
+			t.serialize(*this);
+			// fields a newer writer appended to the object are skipped
+			_cursor = end;
+			_end = outer;
+		}
+		/* reads a length prefix, returns where the object it prefixes ends */
+		const std::uint8_t *open()
+		{
+			std::size_t tagged = _wireFormat.isTagged();
+			need(tagged + sizeof(std::uint32_t));
+			if (tagged && _cursor[0] != TV::ISerializable)
+				throw std::runtime_error("unknown datatype in TV processing");
+			auto length = LittleEndian::load<std::uint32_t>(_cursor + tagged);
+			_cursor += tagged + sizeof(std::uint32_t);
+			need(length);
+			return _cursor + length;
+		}
+		/* throws if less than n bytes are left to read */
+		void need(std::size_t n) const
+		{
+			if (remaining() < n)
+				throw std::runtime_error("read beyond end of buffer in InStream");
+		}
+		template <typename T>
+		IStream &get(T &v)
+		{
+			return get(v, Varint::applies<T>());
+		}
+		/* [tag +] varint, unless the stream uses fixed width integers */
+		template <typename T>
+		IStream &get(T &v, std::true_type)
+		{
+			if (!_wireFormat.hasVarints())
+				return get(v, std::false_type());
+			std::size_t tagged = _wireFormat.isTagged();
+			need(tagged + 1);
+			if (tagged && _cursor[0] != TypeTag<T>::value)
+				throw std::runtime_error("unknown datatype in TV processing");
+			std::uint64_t u;
+			auto n = Varint::decode(_cursor + tagged, _end, u);
+			if (0 == n)
+				throw std::runtime_error("truncated varint in InStream");
+			v = Varint::fromUnsigned<T>(u);
+			_cursor += tagged + n;
+			return *this;
+		}
+		/* [tag +] value read as one block */
+		template <typename T>
+		IStream &get(T &v, std::false_type)
+		{
+			std::size_t tagged = _wireFormat.isTagged();
+			need(tagged + sizeof(T));
+			if (tagged && _cursor[0] != TypeTag<T>::value)
+				throw std::runtime_error("unknown datatype in TV processing");
+			v = LittleEndian::load<T>(_cursor + tagged);
+			_cursor += tagged + sizeof(T);
+			return *this;
+		}
+		template <typename T>
+		void load(T &t, primitiveKind) { get(t); }
+		template <typename T>
+		void load(T &t, containerKind) { transfer(*this, t); }
+		template <typename T>
+		void load(T &t, objectKind) { nested(t); }
+		// local vars
+		const std::uint8_t *_begin;
+		const std::uint8_t *_cursor;
+		const std::uint8_t *_end;
+
+	public:
+		InStream(WireFormat wireFormat = WireFormat()) : IStream(wireFormat), _begin(nullptr), _cursor(nullptr), _end(nullptr) {}
+		InStream(ByteView buf, WireFormat wireFormat = WireFormat()) : IStream(wireFormat) { setBuffer(buf); }
+		InStream(const t_buffer &buf, WireFormat wireFormat = WireFormat()) : IStream(wireFormat) { setBuffer(buf); }
+		// a temporary buffer would be gone before it's decoded
+		InStream(t_buffer &&, WireFormat = WireFormat()) = delete;
+		void setBuffer(ByteView buf)
+		{
+			_begin = _cursor = buf.data();
+			_end = buf.data() + buf.size();
+		}
+		void setBuffer(const t_buffer &buf) { setBuffer(ByteView(buf)); }
+		void setBuffer(t_buffer &&) = delete;
+		/* static dispatch, hides IStream::operator& when the stream type is known */
+		template <typename T>
+		inline InStream &operator&(T &t)
+		{
+			load(t, Kind<T>());
+			return *this;
+		}
+		modes mode() const override { return decoding; }
+		/* reads the length of a container, bounded by what's left when the elements take at least
+		   least bytes each, so a corrupt length doesn't resize a vector past the buffer. Elements that
+		   can take no bytes aren't bounded, maps still build one node per element they decode */
+		std::size_t sequence(std::size_t, std::size_t least) override
+		{
+			std::size_t tagged = _wireFormat.isTagged();
+			need(tagged + 1);
+			if (tagged && _cursor[0] != TV::sequence)
+				throw std::runtime_error("unknown datatype in TV processing");
+			std::uint64_t length;
+			if (_wireFormat.hasVarints())
+			{
+				auto n = Varint::decode(_cursor + tagged, _end, length);
+				if (0 == n)
+					throw std::runtime_error("truncated varint in InStream");
+				_cursor += tagged + n;
+			}
+			else
+			{
+				need(tagged + sizeof(std::uint32_t));
+				length = LittleEndian::load<std::uint32_t>(_cursor + tagged);
+				_cursor += tagged + sizeof(std::uint32_t);
+			}
+			if (0 < least && length > remaining() / least)
+				throw std::runtime_error("container longer than the buffer in InStream");
+			return static_cast<std::size_t>(length);
+		}
+		/* [tag +] the elements as one copy */
+		void block(void *elements, std::size_t count, std::size_t size, std::uint8_t tag) override
+		{
+			std::size_t tagged = _wireFormat.isTagged();
+			need(tagged + count * size);
+			if (tagged && _cursor[0] != tag)
+				throw std::runtime_error("unknown datatype in TV processing");
+			LittleEndian::copy(elements, _cursor + tagged, count, size);
+			_cursor += tagged + count * size;
+		}
+		/* points v at the bytes in the source, nothing is copied */
+		void bytes(ByteView &v) override
+		{
+			auto n = sequence(0, 1);
+			std::size_t tagged = _wireFormat.isTagged();
+			need(tagged + n);
+			if (tagged && _cursor[0] != TV::unsignedByte)
+				throw std::runtime_error("unknown datatype in TV processing");
+			_cursor += tagged;
+			v = take(n);
+		}
+		/* the rest of the nested object in place, not decoded */
+		bool verbatim(ByteView &v, const WireFormat &) override
+		{
+			// without a length prefix the end of the object is only found by decoding it
+			if (!_wireFormat.hasLengthPrefix())
+				return false;
+			v = take(remaining());
+			return true;
+		}
+		/* start reading from the beginning of the range again */
+		void rewind() { _cursor = _begin; }
+		std::size_t remaining() const { return static_cast<std::size_t>(_end - _cursor); }
+		std::size_t consumed() const { return static_cast<std::size_t>(_cursor - _begin); }
+		/* steps over the next nested object in O(1), needs length prefixes */
+		void skip()
+		{
+			if (!_wireFormat.hasLengthPrefix())
+				throw std::runtime_error("skip() needs length-prefixed nested objects in InStream");
+			_cursor = open();
+		}
+		/* the next n bytes in place, consumed without decoding */
+		ByteView take(std::size_t n)
+		{
+			need(n);
+			ByteView v(_cursor, n);
+			_cursor += n;
+			return v;
+		}
+		/* the next single byte value, without consuming it */
+		std::uint8_t peek()
+		{
+			std::size_t tagged = _wireFormat.isTagged();
+			need(tagged + 1);
+			return _cursor[tagged];
+		}
+	};
+	//------------------------------------------------------
+	/*
+		Doesn't serialize anything, it only counts the bytes
+		a serialize() call would produce in the given wire
+		format. Used to presize buffers and to know a length
+		prefix before the payload is written.
+	*/
+	//------------------------------------------------------
+	class MeasureStream : public IStream
+	{
+	private:
+		// implement interface IStream
+		IStream &marshal(bool &v) override { return count(v); }
+		IStream &marshal(std::uint8_t &v) override { return count(v); }
+		IStream &marshal(std::int8_t &v) override { return count(v); }
+		IStream &marshal(std::uint16_t &v) override { return count(v); }
+		IStream &marshal(std::int16_t &v) override { return count(v); }
+		IStream &marshal(std::uint32_t &v) override { return count(v); }
+		IStream &marshal(std::int32_t &v) override { return count(v); }
+		IStream &marshal(std::uint64_t &v) override { return count(v); }
+		IStream &marshal(std::int64_t &v) override { return count(v); }
+		IStream &marshal(float &v) override { return count(v); }
+		IStream &marshal(double &v) override { return count(v); }
+		IStream &marshal(ISerializable &C) override
+		{
+			_size += prefix();
+			C.serialize(*this);
+			return *this;
+		};
+		std::size_t prefix() const { return _wireFormat.hasLengthPrefix() ? _wireFormat.isTagged() + sizeof(std::uint32_t) : 0; }
+		template <typename T>
+		IStream &count(T v)
+		{
+			_size += _wireFormat.isTagged() + width(v, Varint::applies<T>());
+			return *this;
+		}
+		template <typename T>
+		std::size_t width(T v, std::true_type) const
+		{
+			return _wireFormat.hasVarints() ? Varint::size(Varint::toUnsigned(v)) : sizeof(T);
+		}
+		template <typename T>
+		std::size_t width(T, std::false_type) const { return sizeof(T); }
+		template <typename T>
+		void measure(T &t, primitiveKind) { count(t); }
+		template <typename T>
+		void measure(T &t, containerKind) { transfer(*this, t); }
+		template <typename T>
+		void measure(T &t, objectKind)
+		{
+			_size += prefix();
+			t.serialize(*this);
+		}
+		// local vars
+		std::size_t _size;
+
+	public:
+		MeasureStream(WireFormat wireFormat = WireFormat()) : IStream(wireFormat), _size(0) {}
+		/* static dispatch, hides IStream::operator& when the stream type is known */
+		template <typename T>
+		inline MeasureStream &operator&(T &t)
+		{
+			measure(t, Kind<T>());
+			return *this;
+		}
+		modes mode() const override { return encoding; }
+		std::size_t sequence(std::size_t n, std::size_t) override
+		{
+			_size += _wireFormat.isTagged() + (_wireFormat.hasVarints() ? Varint::size(n) : sizeof(std::uint32_t));
+			return n;
+		}
+		void block(void *, std::size_t count, std::size_t size, std::uint8_t) override
+		{
+			_size += _wireFormat.isTagged() + count * size;
+		}
+		bool verbatim(ByteView &v, const WireFormat &format) override
+		{
+			if (!format.sameEncoding(_wireFormat))
+				return false;
+			add(v.size());
+			return true;
+		}
+		std::size_t size() const { return _size; }
+		/* n bytes written as they are, without encoding */
+		void add(std::size_t n) { _size += n; }
+		void reset() { _size = 0; }
+	};
+	/* number of bytes subject serializes into */
+	template <typename T>
+	std::size_t measure(T &subject, WireFormat wireFormat = WireFormat())
+	{
+		MeasureStream s(wireFormat);
+		subject.serialize(s);
+		return s.size();
+	}
+	//------------------------------------------------------
+	/*
+		Compile time size of subjects that only hold fixed
+		size fields. A subject opts in by listing the types
+		it serializes, in serialize() order:
+			typedef Serializer::Fields<std::uint8_t, MyFirst> fields;
+		The sizes are only valid for fixed width integers
+		without length prefixes, varints depend on the values.
+		The list is a copy of serialize() the compiler can't
+		check, fixedSizeMatches() compares it with measure().
+		Messaging::Send keeps measuring, a Message hides the
+		type of its payload.
+	*/
+	//------------------------------------------------------
+	template <typename... Ts>
+	struct Fields
+	{
+	};
+	template <typename T, typename = void>
+	struct FixedSize;
+	template <typename T>
+	struct FixedSize<T, typename std::enable_if<IsPrimitive<T>::value>::type>
+	{
+		static const std::size_t compact = sizeof(T);
+		static const std::size_t tagged = 1 + sizeof(T);
+	};
+	template <>
+	struct FixedSize<Fields<>>
+	{
+		static const std::size_t compact = 0;
+		static const std::size_t tagged = 0;
+	};
+	template <typename T, typename... Ts>
+	struct FixedSize<Fields<T, Ts...>>
+	{
+		static const std::size_t compact = FixedSize<T>::compact + FixedSize<Fields<Ts...>>::compact;
+		static const std::size_t tagged = FixedSize<T>::tagged + FixedSize<Fields<Ts...>>::tagged;
+	};
+	template <typename T>
+	struct FixedSize<T, decltype(void(sizeof(typename T::fields)))> : FixedSize<typename T::fields>
+	{
+	};
+	template <typename T>
+	constexpr std::size_t fixedSize(WireFormat::layouts layout)
+	{
+		return WireFormat::tagged == layout ? FixedSize<T>::tagged : FixedSize<T>::compact;
+	}
+	/* false if T's fields list and its serialize() disagree about the size, in either layout */
+	template <typename T>
+	bool fixedSizeMatches()
+	{
+		T subject;
+		return FixedSize<T>::compact == measure(subject, WireFormat(WireFormat::compact)) &&
+			   FixedSize<T>::tagged == measure(subject, WireFormat(WireFormat::tagged));
+	}
+	//------------------------------------------------------
+	/*
+		Doesn't serialize anything, it folds the sequence of
+		TV tags a serialize() call produces into a 32 bit
+		FNV-1a hash. Used to check once per message that
+		both sides of a compact stream agree on the schema.
+	*/
+	//------------------------------------------------------
+	class SchemaStream : public IStream
+	{
+	private:
+		// implement interface IStream
+		IStream &marshal(bool &) override { return fold(TV::boolean); }
+		IStream &marshal(std::uint8_t &) override { return fold(TV::unsignedByte); }
+		IStream &marshal(std::int8_t &) override { return fold(TV::signedByte); }
+		IStream &marshal(std::uint16_t &) override { return fold(TV::unsignedShort); }
+		IStream &marshal(std::int16_t &) override { return fold(TV::signedShort); }
+		IStream &marshal(std::uint32_t &) override { return fold(TV::unsignedInt); }
+		IStream &marshal(std::int32_t &) override { return fold(TV::signedInt); }
+		IStream &marshal(std::uint64_t &) override { return fold(TV::unsignedLong); }
+		IStream &marshal(std::int64_t &) override { return fold(TV::signedLong); }
+		IStream &marshal(float &) override { return fold(TV::singleFloat); }
+		IStream &marshal(double &) override { return fold(TV::doubleFloat); }
+		IStream &marshal(ISerializable &C) override
+		{
+			fold(TV::ISerializable);
+			C.serialize(*this);
+			return *this;
+		};
+		IStream &fold(std::uint8_t tag)
+		{
+			_hash = (_hash ^ tag) * 16777619u;
+			return *this;
+		}
+		// local vars
+		std::uint32_t _hash;
+
+	public:
+		SchemaStream() : _hash(2166136261u) {}
+		modes mode() const override { return describing; }
+		/* the length doesn't belong to the schema, only that there is a container */
+		std::size_t sequence(std::size_t n, std::size_t) override
+		{
+			fold(TV::sequence);
+			return n;
+		}
+		void block(void *, std::size_t, std::size_t, std::uint8_t tag) override { fold(tag); }
+		std::uint32_t hash() const { return _hash; }
+	};
+	/* schema hash of a serializable subject */
+	inline std::uint32_t schemaOf(ISerializable &subject)
+	{
+		SchemaStream s;
+		subject.serialize(s);
+		return s.hash();
+	}
+	//------------------------------------------------------
+	/*
+		Nested object that's decoded on first access. With
+		length-prefixed nested objects reading only keeps
+		a view of the object's bytes, get() decodes them,
+		without the prefix it's decoded right away.
+		A Lazy that was never accessed is written back by
+		copying those bytes, so a router can forward it
+		without decoding it at all.
+		The view points into the buffer the Lazy was read
+		from, that buffer has to stay valid and unmodified
+		until get() has been called or the Lazy is written
+		or read again.
+	*/
+	//------------------------------------------------------
+	template <typename T>
+	class Lazy : public ISerializable
+	{
+	public:
+		Lazy() : _decoded(true) {}
+		Lazy(const T &value) : _value(value), _decoded(true) {}
+		/* the object, decoded now if it hasn't been yet */
+		T &get()
+		{
+			if (!_decoded)
+				decode();
+			return _value;
+		}
+		T &operator*() { return get(); }
+		T *operator->() { return &get(); }
+		bool decoded() const { return _decoded; }
+		/* the encoded bytes until decoded */
+		ByteView encoded() const { return _encoded; }
+		void serialize(IStream &s) override { serialize<IStream>(s); }
+		/* streams that can't keep the bytes (delta streams...) get the decoded object */
+		template <typename Stream>
+		void serialize(Stream &s)
+		{
+			ByteView v;
+			switch (s.mode())
+			{
+			case IStream::encoding:
+				if (_decoded || !s.verbatim(_encoded, _format))
+					get().serialize(s);
+				break;
+			case IStream::decoding:
+				// a decoder that patches fields needs the current value first
+				if (!s.verbatim(v, s.wireFormat()))
+					get().serialize(s);
+				else
+				{
+					_format = s.wireFormat();
+					_encoded = v;
+					_decoded = false;
+				}
+				break;
+			case IStream::describing:
+				_value.serialize(s);
+				break;
+			}
+		}
+
+	private:
+		void decode()
+		{
+			InStream in(_encoded, _format);
+			_value.serialize(in);
+			_decoded = true;
+			_encoded = ByteView();
+		}
+		T _value;
+		bool _decoded;
+		ByteView _encoded;
+		WireFormat _format;
+	};
+	//------------------------------------------------------
+	/*
+		Delta encoding of an object against a baseline. The
+		primitive fields of an object are numbered in
+		serialize() order (nested objects flattened), a
+		delta is [varint field count][bitmap, bit i set if
+		field i changed][the changed values, in order].
+		rebase() takes a baseline, every encode() compares
+		field by field with it and moves it to the encoded
+		state, so it assumes every delta reaches the other
+		side in order (rebase both sides after a loss).
+	*/
+	//------------------------------------------------------
+	class DeltaOutStream : public IStream
+	{
+	private:
+		// implement interface IStream
+		IStream &marshal(bool &v) override { return field(v); }
+		IStream &marshal(std::uint8_t &v) override { return field(v); }
+		IStream &marshal(std::int8_t &v) override { return field(v); }
+		IStream &marshal(std::uint16_t &v) override { return field(v); }
+		IStream &marshal(std::int16_t &v) override { return field(v); }
+		IStream &marshal(std::uint32_t &v) override { return field(v); }
+		IStream &marshal(std::int32_t &v) override { return field(v); }
+		IStream &marshal(std::uint64_t &v) override { return field(v); }
+		IStream &marshal(std::int64_t &v) override { return field(v); }
+		IStream &marshal(float &v) override { return field(v); }
+		IStream &marshal(double &v) override { return field(v); }
+		IStream &marshal(ISerializable &C) override
+		{
+			C.serialize(*this);
+			return *this;
+		};
+		/* the baseline keeps every field as its fixed width bytes, compared bitwise */
+		template <typename T>
+		IStream &field(T &v)
+		{
+			std::uint8_t bytes[sizeof(T)];
+			LittleEndian::store(bytes, v);
+			if (_capturing)
+				_baseline.insert(_baseline.end(), bytes, bytes + sizeof(T));
+			else
+			{
+				if (_baseline.size() - _position < sizeof(T))
+					throw std::runtime_error("object doesn't match its baseline in DeltaOutStream");
+				auto base = _baseline.data() + _position;
+				if (0 != std::memcmp(base, bytes, sizeof(T)))
+				{
+					std::memcpy(base, bytes, sizeof(T));
+					_values.getbuffer()[_bitmapAt + _field / 8] |= static_cast<std::uint8_t>(1u << (_field % 8));
+					_values &v;
+				}
+				_position += sizeof(T);
+			}
+			++_field;
+			return *this;
+		}
+		template <typename T>
+		void visit(T &t, primitiveKind) { field(t); }
+		template <typename T>
+		void visit(T &, containerKind)
+		{
+			// depends on T, so it only fires for a container that is actually visited
+			static_assert(sizeof(T) == 0, "containers aren't supported by delta streams");
+		}
+		template <typename T>
+		void visit(T &t, objectKind) { t.serialize(*this); }
+		// local vars
+		OutStream _values;
+		OutStream::t_buffer _baseline;
+		std::size_t _position;
+		std::size_t _field;
+		std::size_t _fields;
+		std::size_t _bitmapAt;
+		bool _capturing;
+
+	public:
+		DeltaOutStream(WireFormat wireFormat = WireFormat(WireFormat::compact))
+			: IStream(wireFormat), _values(wireFormat), _position(0), _field(0), _fields(0), _bitmapAt(0), _capturing(false) {}
+		/* static dispatch, hides IStream::operator& when the stream type is known */
+		template <typename T>
+		inline DeltaOutStream &operator&(T &t)
+		{
+			visit(t, Kind<T>());
+			return *this;
+		}
+		modes mode() const override { return encoding; }
+		/* fields are numbered, a container would shift every field after it, only reached through IStream */
+		std::size_t sequence(std::size_t, std::size_t) override { throw std::runtime_error("containers aren't supported by delta streams"); }
+		void block(void *, std::size_t, std::size_t, std::uint8_t) override { throw std::runtime_error("containers aren't supported by delta streams"); }
+		/* the state the other side has now */
+		template <typename T>
+		void rebase(T &baseline)
+		{
+			_baseline.clear();
+			_field = 0;
+			_capturing = true;
+			baseline.serialize(*this);
+			_capturing = false;
+			_fields = _field;
+		}
+		/* the delta from the baseline to current, current becomes the baseline */
+		template <typename T>
+		OutStream::t_buffer &encode(T &current)
+		{
+			_values.reset();
+			Varint::encode(_values.claim(Varint::size(_fields)), _fields);
+			_bitmapAt = _values.size();
+			auto bitmap = (_fields + 7) / 8;
+			std::memset(_values.claim(bitmap), 0, bitmap);
+			_position = 0;
+			_field = 0;
+			current.serialize(*this);
+			if (_field != _fields || _position != _baseline.size())
+				throw std::runtime_error("object doesn't match its baseline in DeltaOutStream, rebase() it");
+			return _values.getbuffer();
+		}
+		/* number of primitive fields of the baseline */
+		std::size_t fields() const { return _fields; }
+	};
+	//------------------------------------------------------
+	/*
+		Applies a delta made by DeltaOutStream, only the
+		fields flagged in the bitmap are decoded, straight
+		into the baseline object, the others keep their
+		value. The wire format has to be the encoder's.
+		If the delta doesn't match, apply() throws and the
+		object may be partially patched.
+	*/
+	//------------------------------------------------------
+	class DeltaInStream : public IStream
+	{
+	private:
+		// implement interface IStream
+		IStream &marshal(bool &v) override { return field(v); }
+		IStream &marshal(std::uint8_t &v) override { return field(v); }
+		IStream &marshal(std::int8_t &v) override { return field(v); }
+		IStream &marshal(std::uint16_t &v) override { return field(v); }
+		IStream &marshal(std::int16_t &v) override { return field(v); }
+		IStream &marshal(std::uint32_t &v) override { return field(v); }
+		IStream &marshal(std::int32_t &v) override { return field(v); }
+		IStream &marshal(std::uint64_t &v) override { return field(v); }
+		IStream &marshal(std::int64_t &v) override { return field(v); }
+		IStream &marshal(float &v) override { return field(v); }
+		IStream &marshal(double &v) override { return field(v); }
+		IStream &marshal(ISerializable &C) override
+		{
+			C.serialize(*this);
+			return *this;
+		};
+		template <typename T>
+		IStream &field(T &v)
+		{
+			if (_field >= _fields)
+				throw std::runtime_error("delta doesn't match the object in DeltaInStream");
+			if (_bitmap[_field / 8] & (1u << (_field % 8)))
+			{
+				_values &v;
+				++_changed;
+			}
+			++_field;
+			return *this;
+		}
+		template <typename T>
+		void visit(T &t, primitiveKind) { field(t); }
+		template <typename T>
+		void visit(T &, containerKind)
+		{
+			// depends on T, so it only fires for a container that is actually visited
+			static_assert(sizeof(T) == 0, "containers aren't supported by delta streams");
+		}
+		template <typename T>
+		void visit(T &t, objectKind) { t.serialize(*this); }
+		// local vars
+		InStream _values;
+		const std::uint8_t *_bitmap;
+		std::size_t _field;
+		std::size_t _fields;
+		std::size_t _changed;
+
+	public:
+		DeltaInStream(WireFormat wireFormat = WireFormat(WireFormat::compact))
+			: IStream(wireFormat), _values(wireFormat), _bitmap(nullptr), _field(0), _fields(0), _changed(0) {}
+		/* static dispatch, hides IStream::operator& when the stream type is known */
+		template <typename T>
+		inline DeltaInStream &operator&(T &t)
+		{
+			visit(t, Kind<T>());
+			return *this;
+		}
+		modes mode() const override { return decoding; }
+		/* fields are numbered, a container would shift every field after it, only reached through IStream */
+		std::size_t sequence(std::size_t, std::size_t) override { throw std::runtime_error("containers aren't supported by delta streams"); }
+		void block(void *, std::size_t, std::size_t, std::uint8_t) override { throw std::runtime_error("containers aren't supported by delta streams"); }
+		/* patches baseline with delta, returns the number of changed fields, a throw leaves it partially patched */
+		template <typename T>
+		std::size_t apply(ByteView delta, T &baseline)
+		{
+			std::uint64_t fields;
+			auto n = Varint::decode(delta.data(), delta.end(), fields);
+			// checked before (fields + 7) / 8 is computed, it wraps for a corrupt count
+			if (0 == n || fields > static_cast<std::uint64_t>(delta.size() - n) * 8)
+				throw std::runtime_error("truncated delta in DeltaInStream");
+			auto bitmap = static_cast<std::size_t>((fields + 7) / 8);
+			_bitmap = delta.data() + n;
+			_fields = static_cast<std::size_t>(fields);
+			_field = 0;
+			_changed = 0;
+			_values.setBuffer(ByteView(_bitmap + bitmap, delta.size() - n - bitmap));
+			baseline.serialize(*this);
+			auto complete = _field == _fields && 0 == _values.remaining();
+			_values.setBuffer(ByteView());
+			if (!complete)
+				throw std::runtime_error("delta doesn't match the object in DeltaInStream");
+			return _changed;
+		}
+	};
+	//------------------------------------------------------
+	/*
+		A large collection serialized in per thread chunks.
+		index[i] is the byte offset of object i as if the
+		chunks were stitched together, chunk c holds the
+		objects from firstObject[c] up to firstObject[c + 1].
+	*/
+	//------------------------------------------------------
+	struct Snapshot
+	{
+		std::vector<OutStream::t_buffer> chunks;
+		std::vector<std::size_t> firstObject;
+		std::vector<std::uint64_t> index;
+		std::size_t size() const
+		{
+			std::size_t total = 0;
+			for (auto &chunk : chunks)
+				total += chunk.size();
+			return total;
+		}
+		/* all chunks as one contiguous buffer */
+		OutStream::t_buffer stitch() const
+		{
+			OutStream::t_buffer buf;
+			buf.reserve(size());
+			for (auto &chunk : chunks)
+				buf.insert(buf.end(), chunk.begin(), chunk.end());
+			return buf;
+		}
+	};
+	/* runs job(part, begin, end) on threads, each on a contiguous share of n items, rethrows the first failed part */
+	template <typename Job>
+	void inParallel(std::size_t n, std::size_t threads, Job job)
+	{
+		if (0 == threads)
+			threads = 1;
+		if (threads > n)
+			threads = n ? n : 1;
+		std::vector<std::exception_ptr> errors(threads);
+		auto guarded = [&job, &errors](std::size_t part, std::size_t begin, std::size_t end) {
+			try
+			{
+				job(part, begin, end);
+			}
+			catch (...)
+			{
+				errors[part] = std::current_exception();
+			}
+		};
+		std::vector<std::thread> pool;
+		try
+		{
+			for (std::size_t part = 1; part < threads; ++part)
+				pool.emplace_back(guarded, part, n * part / threads, n * (part + 1) / threads);
+		}
+		catch (...)
+		{
+			// no thread may be left joinable
+			for (auto &t : pool)
+				t.join();
+			throw;
+		}
+		guarded(0, 0, n / threads);
+		for (auto &t : pool)
+			t.join();
+		for (auto &error : errors)
+			if (error)
+				std::rethrow_exception(error);
+	}
+	//------------------------------------------------------
+	/*
+		Serializes [first, last) across threads, every thread
+		writes a contiguous share of the objects into a chunk
+		of its own, presized from the size of its first object.
+		The iterators have to be random access, the objects
+		are only read.
+	*/
+	//------------------------------------------------------
+	template <typename Iterator>
+	Snapshot parallelSerialize(Iterator first, Iterator last, std::size_t threads, WireFormat wireFormat = WireFormat())
+	{
+		auto n = static_cast<std::size_t>(last - first);
+		Snapshot snapshot;
+		snapshot.index.resize(n);
+		snapshot.chunks.resize(threads ? (threads < n ? threads : (n ? n : 1)) : 1);
+		snapshot.firstObject.resize(snapshot.chunks.size() + 1, n);
+		inParallel(n, snapshot.chunks.size(), [&](std::size_t part, std::size_t begin, std::size_t end) {
+			snapshot.firstObject[part] = begin;
+			OutStream out(wireFormat);
+			if (begin < end)
+				out.reserve(measure(first[begin], wireFormat) * (end - begin));
+			for (auto i = begin; i < end; ++i)
+			{
+				snapshot.index[i] = out.size();
+				out &first[i];
+			}
+			snapshot.chunks[part].swap(out.getbuffer());
+		});
+		// chunk local offsets become global ones
+		std::uint64_t base = 0;
+		for (std::size_t c = 0; c < snapshot.chunks.size(); ++c)
+		{
+			for (auto i = snapshot.firstObject[c]; i < snapshot.firstObject[c + 1]; ++i)
+				snapshot.index[i] += base;
+			base += snapshot.chunks[c].size();
+		}
+		return snapshot;
+	}
+	//------------------------------------------------------
+	/*
+		Deserializes into the existing objects [first, last),
+		using the offset index to split the work, the buffer
+		is decoded in place by every thread.
+	*/
+	//------------------------------------------------------
+	template <typename Iterator>
+	void parallelDeserialize(ByteView buf, const std::vector<std::uint64_t> &index, Iterator first, Iterator last,
+							 std::size_t threads, WireFormat wireFormat = WireFormat())
+	{
+		auto n = static_cast<std::size_t>(last - first);
+		if (index.size() != n)
+			throw std::runtime_error("index doesn't match the objects in parallelDeserialize()");
+		inParallel(n, threads, [&](std::size_t, std::size_t begin, std::size_t end) {
+			if (begin == end)
+				return;
+			auto to = end < n ? index[end] : buf.size();
+			if (index[begin] > to || to > buf.size())
+				throw std::runtime_error("index points beyond the buffer in parallelDeserialize()");
+			InStream in(ByteView(buf.data() + index[begin], static_cast<std::size_t>(to - index[begin])), wireFormat);
+			for (auto i = begin; i < end; ++i)
+				in &first[i];
+		});
+	}
+	/* the same straight from the chunks, one thread per chunk, no stitching needed */
+	template <typename Iterator>
+	void parallelDeserialize(const Snapshot &snapshot, Iterator first, Iterator last, WireFormat wireFormat = WireFormat())
+	{
+		if (static_cast<std::size_t>(last - first) != snapshot.index.size())
+			throw std::runtime_error("snapshot doesn't match the objects in parallelDeserialize()");
+		inParallel(snapshot.chunks.size(), snapshot.chunks.size(), [&](std::size_t, std::size_t begin, std::size_t end) {
+			for (auto c = begin; c < end; ++c)
+			{
+				InStream in(snapshot.chunks[c], wireFormat);
+				for (auto i = snapshot.firstObject[c]; i < snapshot.firstObject[c + 1]; ++i)
+					in &first[i];
+			}
+		});
+	}
+	//------------------------------------------------------
+	/*
+		Archive file layout: the serialized objects back to
+		back, then the index (u64 offset per object), then a
+		fixed size footer. Everything is little-endian.
+		footer: u64 index offset, u64 count, u8 layout,
+		u8 varints, u8 length prefix, u8 reserved, u32 magic
+	*/
+	//------------------------------------------------------
+	struct Archive
+	{
+		static const std::uint32_t magic = 0x43524147; // "GARC"
+		static const std::size_t footerSize = 24;
+	};
+	//------------------------------------------------------
+	/*
+		Streams objects into an archive file, every object is
+		written as soon as it's appended, only the index is
+		kept in memory until close() writes it at the end.
+	*/
+	//------------------------------------------------------
+	class ArchiveWriter
+	{
+	public:
+		ArchiveWriter(const char *path, WireFormat wireFormat = WireFormat())
+			: _file(std::fopen(path, "wb")), _out(wireFormat), _offset(0)
+		{
+			if (nullptr == _file)
+				throw std::runtime_error("can't open archive for writing in ArchiveWriter");
+		}
+		ArchiveWriter(const ArchiveWriter &) = delete;
+		ArchiveWriter &operator=(const ArchiveWriter &) = delete;
+		~ArchiveWriter()
+		{
+			if (nullptr != _file)
+			{
+				try
+				{
+					close();
+				}
+				catch (...)
+				{
+				}
+			}
+		}
+		/* serializes subject to the file, returns its index */
+		template <typename T>
+		std::size_t append(T &subject)
+		{
+			_out.reset();
+			_out &subject;
+			write(_out.data(), _out.size());
+			return _index.size() - 1;
+		}
+		/* the output of parallelSerialize(), made with the writer's wire format */
+		void append(const Snapshot &snapshot)
+		{
+			auto base = _offset;
+			for (auto offset : snapshot.index)
+				_index.push_back(base + offset);
+			for (auto &chunk : snapshot.chunks)
+				put(chunk.data(), chunk.size());
+		}
+		std::size_t count() const { return _index.size(); }
+		/* writes index and footer, the archive is only complete after this */
+		void close()
+		{
+			if (nullptr == _file)
+				return;
+			auto indexOffset = _offset;
+			std::uint8_t entry[sizeof(std::uint64_t)];
+			for (auto offset : _index)
+			{
+				LittleEndian::store(entry, offset);
+				put(entry, sizeof(entry));
+			}
+			std::uint8_t footer[Archive::footerSize] = {};
+			LittleEndian::store(footer, indexOffset);
+			LittleEndian::store(footer + 8, static_cast<std::uint64_t>(_index.size()));
+			footer[16] = _out.wireFormat().layout();
+			footer[17] = _out.wireFormat().hasVarints() ? 1 : 0;
+			footer[18] = _out.wireFormat().hasLengthPrefix() ? 1 : 0;
+			LittleEndian::store(footer + 20, Archive::magic);
+			put(footer, sizeof(footer));
+			auto failed = 0 != std::fclose(_file);
+			_file = nullptr;
+			if (failed)
+				throw std::runtime_error("can't complete archive in ArchiveWriter::close()");
+		}
+
+	private:
+		void write(const std::uint8_t *data, std::size_t size)
+		{
+			_index.push_back(_offset);
+			put(data, size);
+		}
+		void put(const std::uint8_t *data, std::size_t size)
+		{
+			if (nullptr == _file)
+				throw std::runtime_error("archive already closed in ArchiveWriter");
+			if (size != std::fwrite(data, 1, size, _file))
+				throw std::runtime_error("write failed in ArchiveWriter");
+			_offset += size;
+		}
+		std::FILE *_file;
+		OutStream _out;
+		std::vector<std::uint64_t> _index;
+		std::uint64_t _offset;
+	};
+	//------------------------------------------------------
+	/*
+		Maps an archive file read-only and decodes objects by
+		index straight from the mapped pages, nothing is read
+		or copied up front, so only the pages of the objects
+		that are actually loaded (and the index) get touched.
+		Views and streams handed out point into the mapping
+		and are valid as long as the reader lives.
+		Without mmap (non POSIX) the file is read in one go.
+	*/
+	//------------------------------------------------------
+	class ArchiveReader
+	{
+	public:
+		explicit ArchiveReader(const char *path) : _data(nullptr), _size(0), _count(0), _indexOffset(0)
+		{
+			map(path);
+			try
+			{
+				if (_size < Archive::footerSize)
+					throw std::runtime_error("file too short for an archive in ArchiveReader");
+				auto footer = _data + _size - Archive::footerSize;
+				if (Archive::magic != LittleEndian::load<std::uint32_t>(footer + 20))
+					throw std::runtime_error("not an archive in ArchiveReader");
+				_indexOffset = LittleEndian::load<std::uint64_t>(footer);
+				_count = LittleEndian::load<std::uint64_t>(footer + 8);
+				auto indexBytes = _size - Archive::footerSize - _indexOffset;
+				if (_indexOffset > _size - Archive::footerSize || indexBytes / sizeof(std::uint64_t) != _count ||
+					0 != indexBytes % sizeof(std::uint64_t))
+					throw std::runtime_error("corrupt archive index in ArchiveReader");
+				_wireFormat = WireFormat(static_cast<WireFormat::layouts>(footer[16])).withVarints(0 != footer[17]).withLengthPrefix(0 != footer[18]);
+			}
+			catch (...)
+			{
+				unmap();
+				throw;
+			}
+		}
+		ArchiveReader(const ArchiveReader &) = delete;
+		ArchiveReader &operator=(const ArchiveReader &) = delete;
+		~ArchiveReader() { unmap(); }
+		/* number of objects in the archive */
+		std::size_t size() const { return static_cast<std::size_t>(_count); }
+		WireFormat wireFormat() const { return _wireFormat; }
+		/* the serialized bytes of object i, in place */
+		ByteView at(std::size_t i) const
+		{
+			auto begin = offset(i);
+			auto end = i + 1 < _count ? offset(i + 1) : _indexOffset;
+			if (begin > end || end > _indexOffset)
+				throw std::runtime_error("corrupt archive index in ArchiveReader");
+			return ByteView(_data + begin, static_cast<std::size_t>(end - begin));
+		}
+		/* decodes object i into subject */
+		template <typename T>
+		void load(std::size_t i, T &subject) const
+		{
+			InStream in(at(i), _wireFormat);
+			in &subject;
+		}
+		/* constructs object i */
+		template <typename T>
+		T get(std::size_t i) const
+		{
+			T subject;
+			load(i, subject);
+			return subject;
+		}
+
+	private:
+		std::uint64_t offset(std::size_t i) const
+		{
+			if (i >= _count)
+				throw std::runtime_error("index out of range in ArchiveReader");
+			return LittleEndian::load<std::uint64_t>(_data + _indexOffset + i * sizeof(std::uint64_t));
+		}
+#if defined(__unix__) || defined(__APPLE__)
+		void map(const char *path)
+		{
+			auto fd = ::open(path, O_RDONLY);
+			if (fd < 0)
+				throw std::runtime_error("can't open archive in ArchiveReader");
+			struct stat st;
+			if (0 != ::fstat(fd, &st))
+			{
+				::close(fd);
+				throw std::runtime_error("can't stat archive in ArchiveReader");
+			}
+			_size = static_cast<std::size_t>(st.st_size);
+			void *p = _size ? ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+			::close(fd);
+			if (MAP_FAILED == p)
+				throw std::runtime_error("can't map archive in ArchiveReader");
+			if (nullptr != p)
+				::madvise(p, _size, MADV_RANDOM);
+			_data = static_cast<const std::uint8_t *>(p);
+		}
+		void unmap()
+		{
+			if (nullptr != _data)
+				::munmap(const_cast<std::uint8_t *>(_data), _size);
+			_data = nullptr;
+		}
+#else
+		void map(const char *path)
+		{
+			auto file = std::fopen(path, "rb");
+			if (nullptr == file)
+				throw std::runtime_error("can't open archive in ArchiveReader");
+			std::uint8_t block[64 * 1024];
+			std::size_t n;
+			while (0 != (n = std::fread(block, 1, sizeof(block), file)))
+				_copy.insert(_copy.end(), block, block + n);
+			std::fclose(file);
+			_data = _copy.data();
+			_size = _copy.size();
+		}
+		void unmap()
+		{
+			_data = nullptr;
+			OutStream::t_buffer().swap(_copy);
+		}
+		OutStream::t_buffer _copy;
+#endif
+		const std::uint8_t *_data;
+		std::size_t _size;
+		std::uint64_t _count;
+		std::uint64_t _indexOffset;
+		WireFormat _wireFormat;
+	};
+} // namespace Serializer
+/*
+	Compression package, a dependency-free LZ77 block codec
+	in the spirit of LZ4: byte aligned sequences, no entropy
+	coding, so decoding is little more than memcpy.
+*/
+namespace Compression
+{
+	//------------------------------------------------------
+	/*
+	A block is a series of sequences:
+		token		high nibble literal count, low nibble
+					match length - 4, 15 means more follows
+		[255...]	count continued, byte by byte
+		literals
+		u16 offset	back reference, little-endian
+		[255...]	match length continued
+	the last sequence ends after its literals. A match
+	never starts in the last 12 bytes and the last 5 bytes
+	are always literals (the LZ4 block rules).
+	An Lz instance keeps its hash table between calls, so
+	compressing doesn't allocate or clear memory, use one
+	per thread. Decompressing needs no state.
+	*/
+	//------------------------------------------------------
+	class Lz
+	{
+	public:
+		/* worst case compressed size of n bytes */
+		static std::size_t bound(std::size_t n) { return n + n / 255 + 16; }
+		Lz() : _base(1) { _table.fill(0); }
+		/* compresses [src, src + n) into dst, returns the compressed size, 0 if it doesn't fit in capacity */
+		std::size_t compress(const std::uint8_t *src, std::size_t n, std::uint8_t *dst, std::size_t capacity)
+		{
+			if (n > maxInput)
+				throw std::runtime_error("block too large in Lz::compress()");
+			// positions of earlier calls lie below _base and are ignored, so the table is never cleared
+			if (_base > std::numeric_limits<std::uint32_t>::max() - maxInput - 1)
+			{
+				_table.fill(0);
+				_base = 1;
+			}
+			auto ip = src, anchor = src, end = src + n;
+			auto op = dst, oend = dst + capacity;
+			if (n >= tailLimit)
+			{
+				auto matchStartLimit = end - tailLimit;
+				auto matchEndLimit = end - lastLiterals;
+				while (ip < matchStartLimit)
+				{
+					auto sequence = load32(ip);
+					auto &slot = _table[hash(sequence)];
+					auto candidate = slot;
+					slot = static_cast<std::uint32_t>(_base + (ip - src));
+					auto match = candidate < _base ? ip : src + (candidate - _base);
+					if (ip == match || ip - match > maxOffset || load32(match) != sequence)
+					{
+						// the longer nothing matched, the bigger the steps
+						ip += 1 + ((ip - anchor) >> 6);
+						continue;
+					}
+					while (ip > anchor && match > src && ip[-1] == match[-1])
+					{
+						--ip;
+						--match;
+					}
+					auto length = minMatch + extend(ip + minMatch, match + minMatch, matchEndLimit);
+					op = emit(op, oend, anchor, static_cast<std::size_t>(ip - anchor), static_cast<std::uint16_t>(ip - match), length);
+					if (nullptr == op)
+						return 0;
+					ip += length;
+					anchor = ip;
+					if (ip < matchStartLimit)
+						_table[hash(load32(ip - 2))] = static_cast<std::uint32_t>(_base + (ip - 2 - src));
+				}
+			}
+			op = emit(op, oend, anchor, static_cast<std::size_t>(end - anchor), 0, 0);
+			_base += static_cast<std::uint32_t>(n) + 1;
+			return nullptr != op ? static_cast<std::size_t>(op - dst) : 0;
+		}
+		/* decompresses the block [src, src + n) into dst, returns the decompressed size, throws if it's corrupt */
+		static std::size_t decompress(const std::uint8_t *src, std::size_t n, std::uint8_t *dst, std::size_t capacity)
+		{
+			auto ip = src, iend = src + n;
+			auto op = dst, oend = dst + capacity;
+			for (;;)
+			{
+				if (ip >= iend)
+					throw std::runtime_error("truncated block in Lz::decompress()");
+				auto token = *ip++;
+				auto literals = length(ip, iend, token >> 4);
+				if (literals > static_cast<std::size_t>(iend - ip) || literals > static_cast<std::size_t>(oend - op))
+					throw std::runtime_error("literals beyond the block in Lz::decompress()");
+				if (0 != literals)
+					std::memcpy(op, ip, literals);
+				op += literals;
+				ip += literals;
+				if (ip == iend)
+					return static_cast<std::size_t>(op - dst);
+				if (iend - ip < 2)
+					throw std::runtime_error("truncated block in Lz::decompress()");
+				std::size_t offset = Serializer::LittleEndian::load<std::uint16_t>(ip);
+				ip += 2;
+				auto matchLength = minMatch + length(ip, iend, token & 15);
+				if (0 == offset || offset > static_cast<std::size_t>(op - dst) || matchLength > static_cast<std::size_t>(oend - op))
+					throw std::runtime_error("match beyond the block in Lz::decompress()");
+				copyMatch(op, offset, matchLength);
+				op += matchLength;
+			}
+		}
+
+	private:
+		static const std::size_t minMatch = 4;
+		static const std::size_t lastLiterals = 5;
+		static const std::size_t tailLimit = 12;
+		static const std::ptrdiff_t maxOffset = 65535;
+		static const std::size_t maxInput = 0x7E000000;
+		static const unsigned hashBits = 12;
+		static std::uint32_t load32(const std::uint8_t *p) { return Serializer::LittleEndian::load<std::uint32_t>(p); }
+		static std::size_t hash(std::uint32_t sequence) { return (sequence * 2654435761u) >> (32 - hashBits); }
+		/* number of equal bytes at a and b, a stops at limit */
+		static std::size_t extend(const std::uint8_t *a, const std::uint8_t *b, const std::uint8_t *limit)
+		{
+			auto start = a;
+			while (limit - a >= 8)
+			{
+				auto diff = Serializer::LittleEndian::load<std::uint64_t>(a) ^ Serializer::LittleEndian::load<std::uint64_t>(b);
+				if (0 != diff)
+					return static_cast<std::size_t>(a - start) + (Serializer::Varint::countTrailingZeros(diff) >> 3);
+				a += 8;
+				b += 8;
+			}
+			while (a < limit && *a == *b)
+			{
+				++a;
+				++b;
+			}
+			return static_cast<std::size_t>(a - start);
+		}
+		/* one sequence, matchLength 0 for the last one, nullptr if dst is too small */
+		static std::uint8_t *emit(std::uint8_t *op, std::uint8_t *oend, const std::uint8_t *literals, std::size_t count,
+								  std::uint16_t offset, std::size_t matchLength)
+		{
+			auto matchCode = matchLength ? matchLength - minMatch : 0;
+			if (static_cast<std::size_t>(oend - op) < 1 + count / 255 + 1 + count + 2 + matchCode / 255 + 1)
+				return nullptr;
+			auto token = op++;
+			*token = static_cast<std::uint8_t>((count < 15 ? count : 15) << 4);
+			op = more(op, count);
+			if (0 != count)
+				std::memcpy(op, literals, count);
+			op += count;
+			if (0 == matchLength)
+				return op;
+			Serializer::LittleEndian::store(op, offset);
+			op += 2;
+			*token |= static_cast<std::uint8_t>(matchCode < 15 ? matchCode : 15);
+			return more(op, matchCode);
+		}
+		/* the part of a count the nibble can't hold */
+		static std::uint8_t *more(std::uint8_t *op, std::size_t count)
+		{
+			if (count < 15)
+				return op;
+			for (count -= 15; count >= 255; count -= 255)
+				*op++ = 255;
+			*op++ = static_cast<std::uint8_t>(count);
+			return op;
+		}
+		static std::size_t length(const std::uint8_t *&ip, const std::uint8_t *iend, std::size_t nibble)
+		{
+			if (15 != nibble)
+				return nibble;
+			std::uint8_t b;
+			do
+			{
+				if (ip >= iend)
+					throw std::runtime_error("truncated block in Lz::decompress()");
+				b = *ip++;
+				nibble += b;
+			} while (255 == b);
+			return nibble;
+		}
+		/* with offset < length the match overlaps itself and repeats a pattern, copied in doubling chunks */
+		static void copyMatch(std::uint8_t *op, std::size_t offset, std::size_t length)
+		{
+			auto match = op - offset;
+			for (auto chunk = offset; length > 0; chunk = static_cast<std::size_t>(op - match))
+			{
+				auto n = chunk < length ? chunk : length;
+				std::memcpy(op, match, n);
+				op += n;
+				length -= n;
+			}
+		}
+		std::array<std::uint32_t, 1 << hashBits> _table;
+		std::uint32_t _base;
+	};
+} // namespace Compression
+/*
+	Metrics package, counters and latency histograms for
+	Send, recieve, Dispatcher and the Factory. Only built
+	with GOLDIES_METRICS, otherwise every METRIC() hook is
+	compiled away. Each thread writes to its own shard, so
+	the hot path never shares a cache line or takes a lock,
+	snapshot() sums the shards and can be polled any time.
+*/
+#ifdef GOLDIES_METRICS
+namespace Metrics
+{
+	/* message ids are one byte on the wire */
+	const std::size_t maxIds = 256;
+	/* counters have one writer (the owning thread), so no read-modify-write instruction is needed */
+	inline void bump(std::atomic<std::uint64_t> &counter, std::uint64_t n = 1)
+	{
+		counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+	}
+	//------------------------------------------------------
+	/*
+	Log-linear histogram as in HdrHistogram, values below
+	8 get a bucket each, above that every power of two is
+	split in 8 buckets, so any value is within 12.5% of
+	its bucket's bounds over the whole 64 bit range.
+	*/
+	//------------------------------------------------------
+	class Histogram
+	{
+	public:
+		static const std::size_t subBuckets = 8;
+		static const std::size_t buckets = subBuckets + 61 * subBuckets;
+		static std::size_t bucketOf(std::uint64_t v)
+		{
+			if (v < subBuckets)
+				return static_cast<std::size_t>(v);
+			unsigned msb = 63 - Serializer::Varint::countLeadingZeros(v);
+			return subBuckets + (msb - 3) * subBuckets + ((v >> (msb - 3)) & (subBuckets - 1));
+		}
+		/* largest value that ends up in bucket i */
+		static std::uint64_t upperBound(std::size_t i)
+		{
+			if (i < subBuckets)
+				return i;
+			auto msb = (i - subBuckets) / subBuckets + 3;
+			auto sub = (i - subBuckets) % subBuckets;
+			auto lower = (subBuckets + sub) << (msb - 3);
+			return lower + ((std::uint64_t(1) << (msb - 3)) - 1);
+		}
+		void record(std::uint64_t v)
+		{
+			bump(_counts[bucketOf(v)]);
+			bump(_count);
+			bump(_sum, v);
+			if (v > _max.load(std::memory_order_relaxed))
+				_max.store(v, std::memory_order_relaxed);
+		}
+
+	private:
+		friend class Snapshot;
+		std::array<std::atomic<std::uint64_t>, buckets> _counts{};
+		std::atomic<std::uint64_t> _count{0}, _sum{0}, _max{0};
+	};
+	/* what one thread has counted */
+	struct Shard
+	{
+		struct Id
+		{
+			std::atomic<std::uint64_t> sent{0}, bytesOut{0}, received{0}, bytesIn{0};
+		};
+		std::array<Id, maxIds> ids;
+		Histogram encode, decode;
+		std::atomic<std::uint64_t> factoryMisses{0}, factoryThrows{0}, decodeErrors{0};
+	};
+	//------------------------------------------------------
+	/*
+	All shards ever handed out. A shard is never freed, a
+	thread that exits hands its shard back and the next new
+	thread continues on it, so no count is lost and short
+	lived threads don't make the registry grow.
+	*/
+	//------------------------------------------------------
+	class Registry
+	{
+	public:
+		static Registry &instance()
+		{
+			static Registry registry;
+			return registry;
+		}
+		/* the calling thread's shard */
+		static Shard &local()
+		{
+			thread_local Lease lease;
+			return *lease.shard;
+		}
+		template <typename Visitor>
+		void visit(Visitor visitor)
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			for (auto &s : _shards)
+				visitor(static_cast<const Shard &>(*s));
+		}
+
+	private:
+		struct Lease
+		{
+			Lease() : shard(instance().acquire()) {}
+			~Lease() { instance().release(shard); }
+			Shard *shard;
+		};
+		Shard *acquire()
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (!_idle.empty())
+			{
+				auto s = _idle.back();
+				_idle.pop_back();
+				return s;
+			}
+			_shards.emplace_back(new Shard);
+			return _shards.back().get();
+		}
+		void release(Shard *s)
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_idle.push_back(s);
+		}
+		std::mutex _mutex;
+		std::vector<std::unique_ptr<Shard>> _shards;
+		std::vector<Shard *> _idle;
+	};
+	/* nanoseconds since construction */
+	class Stopwatch
+	{
+	public:
+		Stopwatch() : _start(std::chrono::steady_clock::now()) {}
+		std::uint64_t elapsed() const
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count();
+		}
+
+	private:
+		std::chrono::steady_clock::time_point _start;
+	};
+	/* the hooks called through METRIC() */
+	inline void sent(std::size_t id, std::size_t bytes, std::uint64_t ns)
+	{
+		auto &shard = Registry::local();
+		auto &counters = shard.ids[id % maxIds];
+		bump(counters.sent);
+		bump(counters.bytesOut, bytes);
+		shard.encode.record(ns);
+	}
+	inline void received(std::size_t id, std::size_t bytes, std::uint64_t ns)
+	{
+		auto &shard = Registry::local();
+		auto &counters = shard.ids[id % maxIds];
+		bump(counters.received);
+		bump(counters.bytesIn, bytes);
+		shard.decode.record(ns);
+	}
+	inline void factoryMiss() { bump(Registry::local().factoryMisses); }
+	inline void factoryThrow() { bump(Registry::local().factoryThrows); }
+	inline void decodeError() { bump(Registry::local().decodeErrors); }
+	//------------------------------------------------------
+	/*
+	Sum of all shards at one point in time, counters that
+	are being written while the snapshot is taken may show
+	up in the next one. Latencies are in nanoseconds,
+	percentiles are reported as the bucket's upper bound.
+	*/
+	//------------------------------------------------------
+	class Snapshot
+	{
+	public:
+		struct Id
+		{
+			std::size_t id;
+			std::uint64_t sent, bytesOut, received, bytesIn;
+		};
+		struct Latency
+		{
+			std::array<std::uint64_t, Histogram::buckets> counts;
+			std::uint64_t count, sum, max;
+			std::uint64_t mean() const { return count ? sum / count : 0; }
+			std::uint64_t percentile(double p) const
+			{
+				auto rank = static_cast<std::uint64_t>(p / 100.0 * count + 0.5);
+				std::uint64_t seen = 0;
+				for (std::size_t i = 0; i < counts.size(); ++i)
+				{
+					seen += counts[i];
+					if (seen >= rank && seen > 0)
+						return std::min(Histogram::upperBound(i), max);
+				}
+				return max;
+			}
+		};
+		Snapshot() : encode(), decode(), factoryMisses(0), factoryThrows(0), decodeErrors(0)
+		{
+			std::array<Id, maxIds> all{};
+			Registry::instance().visit([&](const Shard &s) {
+				for (std::size_t i = 0; i < maxIds; ++i)
+				{
+					all[i].sent += s.ids[i].sent.load(std::memory_order_relaxed);
+					all[i].bytesOut += s.ids[i].bytesOut.load(std::memory_order_relaxed);
+					all[i].received += s.ids[i].received.load(std::memory_order_relaxed);
+					all[i].bytesIn += s.ids[i].bytesIn.load(std::memory_order_relaxed);
+				}
+				add(encode, s.encode);
+				add(decode, s.decode);
+				factoryMisses += s.factoryMisses.load(std::memory_order_relaxed);
+				factoryThrows += s.factoryThrows.load(std::memory_order_relaxed);
+				decodeErrors += s.decodeErrors.load(std::memory_order_relaxed);
+			});
+			for (std::size_t i = 0; i < maxIds; ++i)
+				if (all[i].sent || all[i].received)
+				{
+					all[i].id = i;
+					ids.push_back(all[i]);
+				}
+		}
+		void writeText(std::ostream &os) const
+		{
+			for (auto &i : ids)
+				os << "id " << i.id << ": sent " << i.sent << " (" << i.bytesOut << " bytes), received "
+				   << i.received << " (" << i.bytesIn << " bytes)\n";
+			writeText(os, "encode", encode);
+			writeText(os, "decode", decode);
+			os << "factory misses " << factoryMisses << ", factory throws " << factoryThrows
+			   << ", decode errors " << decodeErrors << "\n";
+		}
+		void writeJson(std::ostream &os) const
+		{
+			os << "{\"ids\":[";
+			for (std::size_t n = 0; n < ids.size(); ++n)
+				os << (n ? "," : "") << "{\"id\":" << ids[n].id << ",\"sent\":" << ids[n].sent
+				   << ",\"bytesOut\":" << ids[n].bytesOut << ",\"received\":" << ids[n].received
+				   << ",\"bytesIn\":" << ids[n].bytesIn << "}";
+			os << "],\"encode\":";
+			writeJson(os, encode);
+			os << ",\"decode\":";
+			writeJson(os, decode);
+			os << ",\"factoryMisses\":" << factoryMisses << ",\"factoryThrows\":" << factoryThrows
+			   << ",\"decodeErrors\":" << decodeErrors << "}\n";
+		}
+		std::vector<Id> ids;
+		Latency encode, decode;
+		std::uint64_t factoryMisses, factoryThrows, decodeErrors;
+
+	private:
+		static void add(Latency &l, const Histogram &h)
+		{
+			for (std::size_t i = 0; i < Histogram::buckets; ++i)
+				l.counts[i] += h._counts[i].load(std::memory_order_relaxed);
+			l.count += h._count.load(std::memory_order_relaxed);
+			l.sum += h._sum.load(std::memory_order_relaxed);
+			l.max = std::max(l.max, h._max.load(std::memory_order_relaxed));
+		}
+		static void writeText(std::ostream &os, const char *name, const Latency &l)
+		{
+			os << name << " ns: count " << l.count << ", mean " << l.mean() << ", p50 " << l.percentile(50)
+			   << ", p90 " << l.percentile(90) << ", p99 " << l.percentile(99) << ", max " << l.max << "\n";
+		}
+		static void writeJson(std::ostream &os, const Latency &l)
+		{
+			os << "{\"count\":" << l.count << ",\"mean\":" << l.mean() << ",\"p50\":" << l.percentile(50)
+			   << ",\"p90\":" << l.percentile(90) << ",\"p99\":" << l.percentile(99) << ",\"max\":" << l.max << "}";
+		}
+	};
+	/* poll this for the current numbers */
+	inline Snapshot snapshot() { return Snapshot(); }
+} // namespace Metrics
+#endif // GOLDIES_METRICS
+/* 
+	Construction package implements 
+	Factory	Method Pattern [GOF]
+	https://en.wikipedia.org/wiki/Factory_method_pattern
+	But only the generic parts, the rest is implemented by
+	the client SW that utilizes this package.
+*/
+namespace Construction
+{
+	//------------------------------------------------------
+	/*
+	This class plays the role as Creator in the 
+	Factory	Method Pattern 
+	*/
+	//------------------------------------------------------
+	template <typename product>
+	class IProduce
+	{
+	public:
+		typedef product *productPtr;
+		virtual ~IProduce() {}
+		virtual productPtr Create() = 0;
+		/* takes a product back, pooling creators recycle it instead */
+		virtual void Recycle(productPtr p) { delete p; }
+	};
+	//------------------------------------------------------
+	/*
+	Deleter for the RAII handles the factory hands out, it
+	gives the product back to the creator that made it.
+	*/
+	//------------------------------------------------------
+	template <typename product>
+	class Recycler
+	{
+	public:
+		Recycler(IProduce<product> *line = nullptr) : _line(line) {}
+		void operator()(product *p) const { _line->Recycle(p); }
+
+	private:
+		IProduce<product> *_line;
+	};
+	//------------------------------------------------------
+	/*
+	Free list of T objects, released objects are kept and
+	handed out again instead of going back to the heap,
+	so after warm-up acquire() doesn't allocate.
+	The pool isn't thread-safe, use one per thread, and it
+	must outlive the objects it has handed out.
+	*/
+	//------------------------------------------------------
+	template <typename T>
+	class Pool
+	{
+	public:
+		Pool() : _idle(nullptr) {}
+		~Pool()
+		{
+			while (nullptr != _idle)
+				delete pop();
+		}
+		Pool(const Pool &) = delete;
+		Pool &operator=(const Pool &) = delete;
+		T *acquire()
+		{
+			return nullptr != _idle ? pop() : new Node;
+		}
+		void release(T *p)
+		{
+			auto node = static_cast<Node *>(p);
+			node->_next = _idle;
+			_idle = node;
+		}
+		/* preallocate n objects, so the first n acquire() calls don't allocate either */
+		void warmUp(std::size_t n)
+		{
+			while (n--)
+				release(new Node);
+		}
+
+	private:
+		struct Node : T
+		{
+			Node *_next;
+		};
+		Node *pop()
+		{
+			auto node = _idle;
+			_idle = node->_next;
+			return node;
+		}
+		Node *_idle;
+	};
+	//------------------------------------------------------
+	/*
+	Tag types are sparse by default, a dense tag type (a
+	small enum counting from 0) specializes this trait, so
+	the factory can use a flat table indexed by the tag:
+		template <>
+		struct DenseTags<MyIds::type> { static const std::size_t count = 4; };
+	*/
+	//------------------------------------------------------
+	template <typename productTag>
+	struct DenseTags
+	{
+	};
+	template <typename productTag, typename = void>
+	struct IsDense : std::false_type
+	{
+	};
+	template <typename productTag>
+	struct IsDense<productTag, decltype(void(DenseTags<productTag>::count))> : std::true_type
+	{
+	};
+	/* std::hash for enum tags without relying on C++14 library support for it */
+	template <typename productTag, bool = std::is_enum<productTag>::value>
+	struct TagHash : std::hash<productTag>
+	{
+	};
+	template <typename productTag>
+	struct TagHash<productTag, true>
+	{
+		std::size_t operator()(productTag id) const
+		{
+			typedef typename std::underlying_type<productTag>::type underlying;
+			return std::hash<underlying>()(static_cast<underlying>(id));
+		}
+	};
+	//------------------------------------------------------
+	/*
+	Storage of the installed creators, a hash map for
+	sparse tags and a flat array for dense ones.
+	find() returns nullptr when nothing is installed.
+	*/
+	//------------------------------------------------------
+	template <typename productTag, typename Producer, bool dense = IsDense<productTag>::value>
+	class ManufacturingLines
+	{
+	public:
+		Producer find(productTag id) const
+		{
+			auto iter = _lines.find(id);
+			return iter != _lines.end() ? iter->second : nullptr;
+		}
+		void set(productTag id, Producer P) { _lines[id] = P; }
+
+	private:
+		std::unordered_map<productTag, Producer, TagHash<productTag>> _lines;
+	};
+	template <typename productTag, typename Producer>
+	class ManufacturingLines<productTag, Producer, true>
+	{
+	public:
+		ManufacturingLines() { _lines.fill(nullptr); }
+		/* O(1), one bounds check and one load */
+		Producer find(productTag id) const
+		{
+			auto index = static_cast<std::size_t>(id);
+			return index < _lines.size() ? _lines[index] : nullptr;
+		}
+		void set(productTag id, Producer P)
+		{
+			auto index = static_cast<std::size_t>(id);
+			if (index >= _lines.size())
+				throw std::runtime_error("tag outside of DenseTags<productTag>::count in install()...");
+			_lines[index] = P;
+		}
+
+	private:
+		std::array<Producer, DenseTags<productTag>::count> _lines;
+	};
+	//------------------------------------------------------
+	/*
+	This Class plays the role as the factory, which actually
+	holds the factory method of Factory	Method Pattern [GOF]
+	*/
+	//------------------------------------------------------
+	template <typename product, typename productTag>
+	class Factory
+	{
+	private:
+		typedef IProduce<product> *Producer;
+		typedef typename IProduce<product>::productPtr productPtr;
+		typedef ManufacturingLines<productTag, Producer> manufacturingLines;
+		manufacturingLines _manufacturingLines;
+
+	public:
+		/* owns the product, returns it to its creator when released */
+		typedef std::unique_ptr<product, Recycler<product>> productHandle;
+		/* Order a specific object from the factory */
+		productPtr fabricate(productTag id)
+		{
+			auto line = _manufacturingLines.find(id);
+			if (nullptr == line)
+			{
+				METRIC(Metrics::factoryMiss());
+				return nullptr;
+			}
+			return create(line);
+		}
+		/* Order a specific object from the factory, wrapped in an RAII handle */
+		productHandle order(productTag id)
+		{
+			auto line = _manufacturingLines.find(id);
+			if (nullptr == line)
+			{
+				METRIC(Metrics::factoryMiss());
+				return productHandle();
+			}
+			return productHandle(create(line), Recycler<product>(line));
+		}
+		/* install a concrete Creator in the factory */
+		void install(productTag id, Producer P)
+		{
+			if (nullptr == P)
+				throw std::runtime_error("null ptr detected in install(productTag id, Producer P)...");
+			_manufacturingLines.set(id, P);
+		}
+
+	private:
+		static productPtr create(Producer line)
+		{
+			try
+			{
+				return line->Create();
+			}
+			catch (...)
+			{
+				METRIC(Metrics::factoryThrow());
+				throw;
+			}
+		}
+	};
+	/* true if no two of the tags are equal, evaluated at compile time */
+	template <typename productTag>
+	constexpr bool distinct(productTag) { return true; }
+	template <typename productTag, typename... Rest>
+	constexpr bool distinct(productTag first, productTag second, Rest... rest)
+	{
+		return first != second && distinct(first, rest...) && distinct(second, rest...);
+	}
+	//------------------------------------------------------
+	/*
+	Factory populated from a type list of concrete Creators.
+	Every creator type provides a static id, the catalogue
+	owns one instance of each, installs them and checks at
+	compile time that no id is used twice.
+	*/
+	//------------------------------------------------------
+	template <typename product, typename productTag, typename... Lines>
+	class Catalogue : public Factory<product, productTag>
+	{
+		static_assert(distinct(Lines::id...), "two production lines share an id in Catalogue");
+
+	public:
+		Catalogue() { install(std::index_sequence_for<Lines...>()); }
+		template <typename Line>
+		Line &line() { return std::get<Line>(_lines); }
+
+	private:
+		template <std::size_t... I>
+		void install(std::index_sequence<I...>)
+		{
+			int expand[] = {0, (Factory<product, productTag>::install(Lines::id, &std::get<I>(_lines)), 0)...};
+			(void)expand;
+		}
+		std::tuple<Lines...> _lines;
+	};
+} // namespace Construction
+/* Messaging package */
+namespace Messaging
+{
+	//------------------------------------------------------
+	/*
+	Enum wrapper to protect the Messaging name space
+	*/
+	//------------------------------------------------------
+	class MessageIds
+	{
+	public:
+		enum type
+		{
+			msg001,
+			msg002,
+			msg003
+		};
+		static const std::size_t count = 3;
+		static std::uint8_t toUint(type v) { return v; }
+	};
+} // namespace Messaging
+/* message ids are dense, the factory uses a flat table for them */
+namespace Construction
+{
+	template <>
+	struct DenseTags<Messaging::MessageIds::type>
+	{
+		static const std::size_t count = Messaging::MessageIds::count;
+	};
+} // namespace Construction
+namespace Messaging
+{
+	//------------------------------------------------------
+	/*
+	Message class that holds a msg id and a payload, 
+	The payload can be any serializable.
+	*/
+	//------------------------------------------------------
+	class Message : public Serializer::ISerializable
+	{
+		MessageIds::type _id;
+		Serializer::ISerializable *_payload;
+		std::uint32_t _schema;
+
+	public:
+		Message(MessageIds::type id, Serializer::ISerializable *payload) : _id(id), _payload(payload), _schema(0) {}
+		void serialize(Serializer::IStream &s)
+		{
+			auto id = MessageIds::toUint(_id);
+			s &id;
+			if (s.wireFormat().schemaCheck())
+				checkSchema(s);
+			s &*_payload;
+		}
+		/* the schema hash goes in the header, the payload is only checked once */
+		void checkSchema(Serializer::IStream &s)
+		{
+			if (0 == _schema)
+				_schema = Serializer::schemaOf(getPayload());
+			auto schema = _schema;
+			s &schema;
+			if (schema != _schema)
+				throw std::runtime_error("schema mismatch in message serialize()");
+		}
+		MessageIds::type getId() const { return _id; }
+		Serializer::ISerializable &getPayload()
+		{
+			if (nullptr == _payload)
+				throw std::runtime_error("nullptr in message getpayload()");
+			return *_payload;
+		}
+	};
+	//------------------------------------------------------
+	/*
+	Concrete Creator template that recycles its products,
+	the message and its payload live together in one pooled
+	entry, so a warmed up line never allocates.
+	*/
+	//------------------------------------------------------
+	template <typename Payload, MessageIds::type Id>
+	class PooledProductionLine : public Construction::IProduce<Message>
+	{
+	public:
+		typedef Construction::IProduce<Message>::productPtr productPtr;
+		productPtr Create() override { return _pool.acquire(); }
+		void Recycle(productPtr p) override { _pool.release(static_cast<Entry *>(p)); }
+		static const MessageIds::type id = Id;
+		MessageIds::type getId() { return Id; }
+		void warmUp(std::size_t n) { _pool.warmUp(n); }
+
+	private:
+		struct Entry : Message
+		{
+			Entry() : Message(Id, &_payload) {}
+			Payload _payload;
+		};
+		Construction::Pool<Entry> _pool;
+	};
+	//------------------------------------------------------
+	/*
+	Frame layout used on byte streams (TCP, pipes, files),
+	all fields little-endian:
+		u32 length	number of payload bytes after the header
+		u8  type	message id, routing needs no decoding
+		u8  flags	Frame::flags
+		payload		the message as package() encodes it
+	A batch frame carries many messages in one payload:
+		u32 count	number of messages
+		message...	back to back, each as package() encodes it
+	the type of a batch frame is the id of its first message.
+	A compressed frame (single or batch) carries:
+		u32 length	payload bytes before compression
+		block		the payload as Compression::Lz block
+	*/
+	//------------------------------------------------------
+	class Frame
+	{
+	public:
+		static const std::size_t headerSize = 6;
+		/* frames beyond this are treated as a corrupt stream */
+		static const std::uint32_t maxLength = 16 * 1024 * 1024;
+		enum flags : std::uint8_t
+		{
+			none = 0,
+			batch = 1,
+			compressed = 2
+		};
+		struct Header
+		{
+			std::uint32_t length;
+			std::uint8_t type;
+			std::uint8_t flags;
+		};
+		static void write(std::uint8_t *p, const Header &h)
+		{
+			Serializer::LittleEndian::store(p, h.length);
+			p[4] = h.type;
+			p[5] = h.flags;
+		}
+		static Header read(const std::uint8_t *p)
+		{
+			Header h;
+			h.length = Serializer::LittleEndian::load<std::uint32_t>(p);
+			h.type = p[4];
+			h.flags = p[5];
+			if (h.length > maxLength)
+				throw std::runtime_error("frame length exceeds Frame::maxLength");
+			return h;
+		}
+		/* header of a frame with length payload bytes, checked on the sending side as well */
+		static Header make(std::size_t length, std::uint8_t type, std::uint8_t flags)
+		{
+			if (length > maxLength)
+				throw std::runtime_error("frame length exceeds Frame::maxLength");
+			Header h = {static_cast<std::uint32_t>(length), type, flags};
+			return h;
+		}
+	};
+	//------------------------------------------------------
+	/*
+	Send class is able to sent a message surprisingly enough
+	gather()/writev() produce a frame as segments, blocks
+	of at least gatherAbove() bytes are sent from where
+	they are instead of being copied into the buffer
+	first. Those frames are never compressed.
+	*/
+	//------------------------------------------------------
+	class Send
+	{
+	public:
+		Send(Serializer::WireFormat wireFormat = Serializer::WireFormat())
+			: _toOutput(wireFormat), _toSegments(wireFormat), _batchCount(0), _compressAbove(std::numeric_limits<std::size_t>::max())
+		{
+			_toSegments.gatherAbove(1024);
+		}
+		/* frames with at least threshold payload bytes get compressed, unless that doesn't make them smaller */
+		Send &compressAbove(std::size_t threshold)
+		{
+			_compressAbove = threshold;
+			return *this;
+		}
+		/* convert message to byte stream, the buffer is presized so it never reallocates while writing */
+		Serializer::OutStream::t_buffer &package(Message &msg)
+		{
+			METRIC(Metrics::Stopwatch watch);
+			_toOutput.reset();
+			_toOutput.reserve(measure(msg));
+			msg.serialize(_toOutput);
+			METRIC(Metrics::sent(msg.getId(), _toOutput.size(), watch.elapsed()));
+			return _toOutput.getbuffer();
+		}
+		/* as package(), but serialized directly into caller memory, returns the bytes written */
+		std::size_t into(Message &msg, std::uint8_t *p, std::size_t capacity)
+		{
+			METRIC(Metrics::Stopwatch watch);
+			_toOutput.attach(p, capacity);
+			try
+			{
+				msg.serialize(_toOutput);
+			}
+			catch (...)
+			{
+				_toOutput.detach();
+				throw;
+			}
+			auto written = _toOutput.size();
+			_toOutput.detach();
+			METRIC(Metrics::sent(msg.getId(), written, watch.elapsed()));
+			return written;
+		}
+		/* as package(), but with a frame header in front for byte streams */
+		Serializer::OutStream::t_buffer &frame(Message &msg)
+		{
+			METRIC(Metrics::Stopwatch watch);
+			auto size = measure(msg);
+			auto h = Frame::make(size, MessageIds::toUint(msg.getId()), Frame::none);
+			_toOutput.reset();
+			_toOutput.reserve(Frame::headerSize + size);
+			Frame::write(_toOutput.claim(Frame::headerSize), h);
+			msg.serialize(_toOutput);
+			METRIC(Metrics::sent(msg.getId(), _toOutput.size(), watch.elapsed()));
+			return seal(_toOutput.getbuffer());
+		}
+		/* start a batch frame, append() messages to it and seal it with finishBatch() */
+		void beginBatch(std::size_t expectedBytes = 0)
+		{
+			_toOutput.reset();
+			_toOutput.reserve(Frame::headerSize + sizeof(std::uint32_t) + expectedBytes);
+			_toOutput.claim(Frame::headerSize + sizeof(std::uint32_t));
+			_batchCount = 0;
+		}
+		void append(Message &msg)
+		{
+			if (0 == _batchCount)
+				_toOutput.getbuffer()[4] = MessageIds::toUint(msg.getId());
+			METRIC(Metrics::Stopwatch watch; auto before = _toOutput.size());
+			msg.serialize(_toOutput);
+			METRIC(Metrics::sent(msg.getId(), _toOutput.size() - before, watch.elapsed()));
+			++_batchCount;
+		}
+		Serializer::OutStream::t_buffer &finishBatch()
+		{
+			auto &buf = _toOutput.getbuffer();
+			auto h = Frame::make(buf.size() - Frame::headerSize, buf[4], Frame::batch);
+			Frame::write(buf.data(), h);
+			Serializer::LittleEndian::store(buf.data() + Frame::headerSize, _batchCount);
+			return seal(buf);
+		}
+		/* blocks of at least threshold bytes are referenced by gather()/writev(), 1024 by default */
+		Send &gatherAbove(std::size_t threshold)
+		{
+			_toSegments.gatherAbove(threshold);
+			return *this;
+		}
+		/* as frame(), but as segments, valid until the next call and as long as msg's blocks are */
+		const std::vector<Serializer::ByteView> &gather(Message &msg)
+		{
+			METRIC(Metrics::Stopwatch watch);
+			_toSegments.reset();
+			_toSegments.claim(Frame::headerSize);
+			msg.serialize(_toSegments);
+			// the header is the start of the own buffer, referenced blocks come after it
+			auto h = Frame::make(_toSegments.size() - Frame::headerSize, MessageIds::toUint(msg.getId()), Frame::none);
+			Frame::write(_toSegments.getbuffer().data(), h);
+			METRIC(Metrics::sent(msg.getId(), _toSegments.size(), watch.elapsed()));
+			return _toSegments.segments();
+		}
+#if defined(__unix__) || defined(__APPLE__)
+		/* gather(msg) written to a blocking fd with as few writev() calls as it takes, returns the bytes */
+		std::size_t writev(int fd, Message &msg)
+		{
+			auto &segments = gather(msg);
+			_iovecs.resize(segments.size());
+			for (std::size_t i = 0; i < segments.size(); ++i)
+			{
+				_iovecs[i].iov_base = const_cast<std::uint8_t *>(segments[i].data());
+				_iovecs[i].iov_len = segments[i].size();
+			}
+			std::size_t total = 0;
+			for (std::size_t first = 0; first < _iovecs.size();)
+			{
+				auto n = ::writev(fd, &_iovecs[first], static_cast<int>(std::min<std::size_t>(_iovecs.size() - first, IOV_MAX)));
+				if (n < 0)
+				{
+					if (EINTR == errno)
+						continue;
+					throw std::runtime_error("writev() failed in Send");
+				}
+				total += static_cast<std::size_t>(n);
+				// a short write resumes inside the segment it stopped in
+				auto left = static_cast<std::size_t>(n);
+				while (first < _iovecs.size() && left >= _iovecs[first].iov_len)
+					left -= _iovecs[first++].iov_len;
+				if (left > 0)
+				{
+					_iovecs[first].iov_base = static_cast<std::uint8_t *>(_iovecs[first].iov_base) + left;
+					_iovecs[first].iov_len -= left;
+				}
+			}
+			return total;
+		}
+#endif
+		/* a whole range of messages (or pointers to them) as one batch frame */
+		template <typename Iterator>
+		Serializer::OutStream::t_buffer &batch(Iterator first, Iterator last)
+		{
+			beginBatch();
+			for (; first != last; ++first)
+				append(deref(*first));
+			return finishBatch();
+		}
+		/* exact number of bytes package() produces for msg */
+		std::size_t measure(Message &msg)
+		{
+			return Serializer::measure(msg, _toOutput.wireFormat());
+		}
+
+	private:
+		static Message &deref(Message &msg) { return msg; }
+		static Message &deref(Message *msg) { return *msg; }
+		/* the frame compressed if it's big enough and it pays off, else the frame itself */
+		Serializer::OutStream::t_buffer &seal(Serializer::OutStream::t_buffer &frame)
+		{
+			auto length = frame.size() - Frame::headerSize;
+			if (length < _compressAbove || length <= sizeof(std::uint32_t))
+				return frame;
+			auto start = Frame::headerSize + sizeof(std::uint32_t);
+			_compressed.resize(Frame::headerSize + length);
+			auto n = _lz.compress(frame.data() + Frame::headerSize, length, _compressed.data() + start, length - sizeof(std::uint32_t) - 1);
+			if (0 == n)
+				return frame;
+			Frame::Header h = {static_cast<std::uint32_t>(sizeof(std::uint32_t) + n), frame[4], static_cast<std::uint8_t>(frame[5] | Frame::compressed)};
+			Frame::write(_compressed.data(), h);
+			Serializer::LittleEndian::store(_compressed.data() + Frame::headerSize, static_cast<std::uint32_t>(length));
+			_compressed.resize(start + n);
+			return _compressed;
+		}
+		Serializer::OutStream _toOutput;
+		Serializer::OutStream _toSegments;
+		std::uint32_t _batchCount;
+		std::size_t _compressAbove;
+		Compression::Lz _lz;
+		Serializer::OutStream::t_buffer _compressed;
+#if defined(__unix__) || defined(__APPLE__)
+		std::vector<iovec> _iovecs;
+#endif
+	};
+	/* id of the next message, empty or truncated input counts as a decode error */
+	inline std::uint8_t peekId(Serializer::InStream &in)
+	{
+		try
+		{
+			return in.peek();
+		}
+		catch (...)
+		{
+			METRIC(Metrics::decodeError());
+			throw;
+		}
+	}
+	//------------------------------------------------------
+	/*
+	Recieve class can reconstruct a message from a stream 
+	of bytes. This class utilizes the Construction package
+	to fabricate classes that knows serialization details
+
+	Buffer ownership:
+	package() decodes in place from the memory it's handed,
+	nothing is copied before the fields are decoded. The
+	caller keeps ownership of that memory (socket buffer,
+	ring slot, mmap'ed region...) and it only has to stay
+	valid and unmodified until package() returns. The
+	returned message holds its own copy of every decoded
+	field, so the I/O buffer can be reused right away.
+	Compressed frames are the exception, inflate() copies
+	them into a buffer of the receiver before decoding.
+	View fields (ByteView, std::string_view) are the other
+	exception, they point into the decoded memory: a
+	message with views is only valid as long as the buffer
+	handed to package()/batch() is, and for compressed
+	frames until the next inflate(). A forwarder can read
+	a few bytes of a view and send the message on without
+	copying the blob out first.
+	Messages come back as handles, released handles go back
+	to the production line, pooled lines recycle them.
+	A recieve instance isn't thread-safe, use one per
+	receiving thread.
+	*/
+	//------------------------------------------------------
+	class recieve
+	{
+	public:
+		typedef Construction::Factory<Message, MessageIds::type> t_factory;
+		typedef t_factory::productHandle t_handle;
+		/* Needs a factory to work with to reconstruct objects */
+		recieve(t_factory &factory, Serializer::WireFormat wireFormat = Serializer::WireFormat())
+			: _input(wireFormat), _factory(factory), _consumed(0) {}
+		/* turn byte stream back to message, decoding straight from buf */
+		t_handle package(Serializer::ByteView buf)
+		{
+			_input.setBuffer(buf);
+			auto product = next();
+			_consumed = _input.consumed();
+			_input.setBuffer(Serializer::ByteView());
+			return product;
+		}
+		/* same as above for a raw pointer/length pair */
+		t_handle package(const std::uint8_t *data, std::size_t size)
+		{
+			return package(Serializer::ByteView(data, size));
+		}
+		/* decode the payload of a batch frame in one pass, onMessage(t_handle) is called per message */
+		template <typename Handler>
+		std::uint32_t batch(Serializer::ByteView buf, Handler onMessage)
+		{
+			if (buf.size() < sizeof(std::uint32_t))
+				throw std::runtime_error("batch without header in recieve::batch()");
+			auto count = Serializer::LittleEndian::load<std::uint32_t>(buf.data());
+			_input.setBuffer(Serializer::ByteView(buf.data() + sizeof(count), buf.size() - sizeof(count)));
+			for (std::uint32_t i = 0; i < count; ++i)
+				onMessage(next());
+			_consumed = sizeof(count) + _input.consumed();
+			_input.setBuffer(Serializer::ByteView());
+			return count;
+		}
+		/* number of bytes the last package()/batch() call decoded */
+		std::size_t consumed() const { return _consumed; }
+		/* the payload of a compressed frame decompressed, valid until the next call */
+		Serializer::ByteView inflate(Serializer::ByteView payload)
+		{
+			if (payload.size() < sizeof(std::uint32_t))
+				throw std::runtime_error("compressed frame without length in recieve::inflate()");
+			auto length = Serializer::LittleEndian::load<std::uint32_t>(payload.data());
+			if (length > Frame::maxLength)
+				throw std::runtime_error("frame length exceeds Frame::maxLength");
+			_inflated.resize(length);
+			auto n = Compression::Lz::decompress(payload.data() + sizeof(length), payload.size() - sizeof(length), _inflated.data(), length);
+			if (n != length)
+				throw std::runtime_error("compressed frame length mismatch in recieve::inflate()");
+			return Serializer::ByteView(_inflated);
+		}
+
+	private:
+		/* fabricate and decode the message at the read position of _input */
+		t_handle next()
+		{
+			METRIC(Metrics::Stopwatch watch; auto before = _input.consumed());
+			auto id = static_cast<MessageIds::type>(peekId(_input));
+			auto product = _factory.order(id);
+			if (nullptr == product)
+				throw std::runtime_error("null ptr detected in recieve, no production line for message id!!");
+			try
+			{
+				product->serialize(_input);
+			}
+			catch (...)
+			{
+				METRIC(Metrics::decodeError());
+				throw;
+			}
+			METRIC(Metrics::received(id, _input.consumed() - before, watch.elapsed()));
+			return product;
+		}
+		Serializer::InStream _input;
+		t_factory &_factory;
+		std::size_t _consumed;
+		Serializer::InStream::t_buffer _inflated;
+	};
+	//------------------------------------------------------
+	/*
+	Typed alternative to recieve for the hot path. Handlers
+	register per message id with a callback on the concrete
+	payload type, the payload is decoded straight into an
+	instance owned by the handler slot and the callback is
+	invoked: no factory, no new, no dynamic_cast, and for
+	Serializable payloads no virtual calls either.
+	The payload instance is reused for every message, copy
+	out what has to outlive the callback. Buffer ownership
+	is the same as for recieve::package(), view fields of
+	the payload are only valid during the callback.
+	*/
+	//------------------------------------------------------
+	class Dispatcher
+	{
+	public:
+		Dispatcher(Serializer::WireFormat wireFormat = Serializer::WireFormat()) : _input(wireFormat), _consumed(0) {}
+		Dispatcher(const Dispatcher &) = delete;
+		Dispatcher &operator=(const Dispatcher &) = delete;
+		/* handler is called as handler(Payload &) for every message with this id */
+		template <typename Payload, typename Handler>
+		void on(MessageIds::type id, Handler handler)
+		{
+			auto index = static_cast<std::size_t>(id);
+			if (index >= _slots.size())
+				throw std::runtime_error("message id out of range in Dispatcher::on()");
+			auto slot = new Slot<Payload, Handler>(handler);
+			if (_input.wireFormat().schemaCheck())
+				slot->_schema = Serializer::schemaOf(slot->_payload);
+			_slots[index].reset(slot);
+		}
+		/* decode one message from buf and dispatch it, false if no handler is registered for it */
+		bool dispatch(Serializer::ByteView buf)
+		{
+			_input.setBuffer(buf);
+			auto handled = next();
+			_consumed = _input.consumed();
+			_input.setBuffer(Serializer::ByteView());
+			return handled;
+		}
+		/* dispatch every message of a batch payload, all ids need a handler */
+		std::uint32_t dispatchBatch(Serializer::ByteView buf)
+		{
+			if (buf.size() < sizeof(std::uint32_t))
+				throw std::runtime_error("batch without header in Dispatcher::dispatchBatch()");
+			auto count = Serializer::LittleEndian::load<std::uint32_t>(buf.data());
+			_input.setBuffer(Serializer::ByteView(buf.data() + sizeof(count), buf.size() - sizeof(count)));
+			for (std::uint32_t i = 0; i < count; ++i)
+				if (!next())
+					throw std::runtime_error("no handler in Dispatcher::dispatchBatch(), the rest of the batch can't be found");
+			_consumed = sizeof(count) + _input.consumed();
+			_input.setBuffer(Serializer::ByteView());
+			return count;
+		}
+		/* number of bytes the last dispatch call decoded */
+		std::size_t consumed() const { return _consumed; }
+
+	private:
+		struct SlotBase
+		{
+			typedef void (*t_decode)(SlotBase &, Serializer::InStream &);
+			typedef void (*t_destroy)(SlotBase *);
+			SlotBase(t_decode decode, t_destroy destroy) : _decode(decode), _destroy(destroy), _schema(0) {}
+			t_decode _decode;
+			t_destroy _destroy;
+			std::uint32_t _schema;
+		};
+		template <typename Payload, typename Handler>
+		struct Slot : SlotBase
+		{
+			Slot(Handler handler) : SlotBase(&decode, &destroy), _handler(handler) {}
+			static void decode(SlotBase &base, Serializer::InStream &in)
+			{
+				auto &self = static_cast<Slot &>(base);
+				METRIC(Metrics::Stopwatch watch; auto before = in.consumed());
+				std::uint8_t id;
+				try
+				{
+					in &id;
+					if (in.wireFormat().schemaCheck())
+					{
+						std::uint32_t schema;
+						in &schema;
+						if (schema != self._schema)
+							throw std::runtime_error("schema mismatch in Dispatcher");
+					}
+					in &self._payload;
+				}
+				catch (...)
+				{
+					METRIC(Metrics::decodeError());
+					throw;
+				}
+				METRIC(Metrics::received(id, in.consumed() - before, watch.elapsed()));
+				self._handler(self._payload);
+			}
+			static void destroy(SlotBase *base) { delete static_cast<Slot *>(base); }
+			Payload _payload;
+			Handler _handler;
+		};
+		struct Destroy
+		{
+			void operator()(SlotBase *slot) const { slot->_destroy(slot); }
+		};
+		bool next()
+		{
+			auto index = static_cast<std::size_t>(peekId(_input));
+			if (index >= _slots.size() || !_slots[index])
+				return false;
+			auto &slot = *_slots[index];
+			slot._decode(slot, _input);
+			return true;
+		}
+		Serializer::InStream _input;
+		std::array<std::unique_ptr<SlotBase, Destroy>, MessageIds::count> _slots;
+		std::size_t _consumed;
+	};
+	/* decode one complete frame (header included), returns the number of messages handed to onMessage */
+	template <typename Handler>
+	std::size_t decodeFrame(recieve &receiver, Serializer::ByteView frame, Handler &onMessage)
+	{
+		auto h = Frame::read(frame.data());
+		Serializer::ByteView payload(frame.data() + Frame::headerSize, h.length);
+		if (h.flags & Frame::compressed)
+			payload = receiver.inflate(payload);
+		std::size_t messages = 1;
+		if (h.flags & Frame::batch)
+			messages = receiver.batch(payload, onMessage);
+		else
+			onMessage(receiver.package(payload));
+		if (receiver.consumed() != payload.size())
+			throw std::runtime_error("frame length doesn't match its message in decodeFrame()");
+		return messages;
+	}
+	//------------------------------------------------------
+	/*
+	Splits a byte stream into frames. Chunks of any size
+	are fed as they arrive, every complete frame is handed
+	on right away. Frames that lie completely inside a
+	chunk are handed on in place from the caller's memory,
+	only a frame that straddles two chunks is collected in
+	a small pending buffer, each byte is looked at once.
+	A frame onFrame() throws for is consumed all the same,
+	the rest of the chunk is still handed on and the first
+	exception is rethrown at the end of feed().
+	*/
+	//------------------------------------------------------
+	class FrameSplitter
+	{
+	public:
+		/* onFrame(Serializer::ByteView frame) per complete frame, returns the number of frames */
+		template <typename Handler>
+		std::size_t feed(const std::uint8_t *data, std::size_t size, Handler onFrame)
+		{
+			std::size_t frames = 0;
+			std::exception_ptr failure;
+			// complete the frame that was cut off by the previous chunk
+			while (!_pending.empty() && size > 0)
+			{
+				auto wanted = missing();
+				auto n = wanted < size ? wanted : size;
+				_pending.insert(_pending.end(), data, data + n);
+				data += n;
+				size -= n;
+				if (_pending.size() >= Frame::headerSize && 0 == missing())
+				{
+					deliver(onFrame, Serializer::ByteView(_pending), failure);
+					_pending.clear();
+					++frames;
+				}
+			}
+			if (!_pending.empty())
+			{
+				if (failure)
+					std::rethrow_exception(failure);
+				return frames;
+			}
+			// the rest of the frames directly out of the chunk
+			while (size >= Frame::headerSize)
+			{
+				auto h = Frame::read(data);
+				auto frameSize = Frame::headerSize + h.length;
+				if (size < frameSize)
+					break;
+				deliver(onFrame, Serializer::ByteView(data, frameSize), failure);
+				data += frameSize;
+				size -= frameSize;
+				++frames;
+			}
+			_pending.assign(data, data + size);
+			if (failure)
+				std::rethrow_exception(failure);
+			return frames;
+		}
+		/* bytes of an incomplete frame waiting for the next chunk */
+		std::size_t pending() const { return _pending.size(); }
+
+	private:
+		/* the first exception is kept for the end of feed(), the frame counts as consumed */
+		template <typename Handler>
+		static void deliver(Handler &onFrame, Serializer::ByteView frame, std::exception_ptr &failure)
+		{
+			try
+			{
+				onFrame(frame);
+			}
+			catch (...)
+			{
+				if (!failure)
+					failure = std::current_exception();
+			}
+		}
+		/* bytes still needed to complete the header, or else the frame */
+		std::size_t missing() const
+		{
+			if (_pending.size() < Frame::headerSize)
+				return Frame::headerSize - _pending.size();
+			return Frame::headerSize + Frame::read(_pending.data()).length - _pending.size();
+		}
+		Serializer::InStream::t_buffer _pending;
+	};
+	//------------------------------------------------------
+	/*
+	Incremental decoder for a stream of frames, splits the
+	stream and decodes every complete frame right away.
+	View fields of a message are valid during onMessage()
+	only, they point into the chunk or the pending buffer.
+	*/
+	//------------------------------------------------------
+	class FrameDecoder
+	{
+	public:
+		FrameDecoder(recieve &receiver) : _receiver(receiver) {}
+		/* returns the number of messages handed to onMessage(recieve::t_handle) */
+		template <typename Handler>
+		std::size_t feed(const std::uint8_t *data, std::size_t size, Handler onMessage)
+		{
+			std::size_t messages = 0;
+			_splitter.feed(data, size, [this, &messages, &onMessage](Serializer::ByteView frame) {
+				messages += decodeFrame(_receiver, frame, onMessage);
+			});
+			return messages;
+		}
+		/* bytes of an incomplete frame waiting for the next chunk */
+		std::size_t pending() const { return _splitter.pending(); }
+
+	private:
+		recieve &_receiver;
+		FrameSplitter _splitter;
+	};
+} // namespace Messaging
+/*
+	Transport package, in-process hand-off of serialized
+	messages between threads through bounded lock-free
+	rings of fixed size slots. Send serializes straight
+	into a claimed slot and recieve decodes in place from
+	it, the bytes are never copied in between.
+*/
+namespace Transport
+{
+	//------------------------------------------------------
+	/*
+	Index padded to a cache line of its own, so producer
+	and consumer don't invalidate each other's lines.
+	*/
+	//------------------------------------------------------
+	static const std::size_t cacheLine = 64;
+	struct alignas(cacheLine) PaddedIndex
+	{
+		PaddedIndex() : value(0) {}
+		std::atomic<std::size_t> value;
+	};
+	//------------------------------------------------------
+	/*
+	Fixed array of T aligned to a cache line, the default
+	allocator only guarantees that since C++17.
+	*/
+	//------------------------------------------------------
+	template <typename T>
+	class CacheAligned
+	{
+	public:
+		CacheAligned(std::size_t n) : _raw(new std::uint8_t[n * sizeof(T) + cacheLine]), _size(n)
+		{
+			auto at = reinterpret_cast<std::uintptr_t>(_raw.get());
+			_items = reinterpret_cast<T *>((at + cacheLine - 1) & ~(cacheLine - 1));
+			for (std::size_t i = 0; i < _size; ++i)
+				new (&_items[i]) T();
+		}
+		~CacheAligned()
+		{
+			for (std::size_t i = 0; i < _size; ++i)
+				_items[i].~T();
+		}
+		CacheAligned(const CacheAligned &) = delete;
+		CacheAligned &operator=(const CacheAligned &) = delete;
+		T &operator[](std::size_t i) { return _items[i]; }
+		std::size_t size() const { return _size; }
+
+	private:
+		std::unique_ptr<std::uint8_t[]> _raw;
+		T *_items;
+		std::size_t _size;
+	};
+	//------------------------------------------------------
+	/*
+	One slot holds one serialized message of at most
+	SlotSize bytes, length 0 marks a slot without message.
+	*/
+	//------------------------------------------------------
+	template <std::size_t SlotSize>
+	struct alignas(cacheLine) Slot
+	{
+		std::atomic<std::size_t> sequence;
+		std::uint32_t length;
+		std::uint8_t data[SlotSize];
+	};
+	/* a range of consecutive slots handed out by claim()/take() */
+	struct Claim
+	{
+		std::size_t first;
+		std::size_t count;
+	};
+	//------------------------------------------------------
+	/*
+	Single producer, single consumer ring.
+	The producer claims up to n free slots, fills them and
+	commits them in one go, the consumer takes up to n
+	filled slots and releases them after decoding. Each
+	side only caches the other side's index, so a batch
+	costs one acquire load and one release store per side.
+	*/
+	//------------------------------------------------------
+	template <std::size_t SlotSize = 256>
+	class SpscRing
+	{
+	public:
+		typedef Slot<SlotSize> t_slot;
+		/* capacity is rounded up to a power of two */
+		SpscRing(std::size_t capacity) : _slots(roundUp(capacity)), _mask(_slots.size() - 1), _cachedHead(0), _cachedTail(0) {}
+		std::size_t capacity() const { return _slots.size(); }
+		t_slot &slot(std::size_t index) { return _slots[index & _mask]; }
+		// producer side
+		Claim claim(std::size_t n)
+		{
+			auto tail = _tail.value.load(std::memory_order_relaxed);
+			if (tail + n - _cachedHead > _slots.size())
+				_cachedHead = _head.value.load(std::memory_order_acquire);
+			auto free = _slots.size() - (tail - _cachedHead);
+			Claim c = {tail, n < free ? n : free};
+			return c;
+		}
+		void commit(const Claim &c) { _tail.value.store(c.first + c.count, std::memory_order_release); }
+		// consumer side
+		Claim take(std::size_t n)
+		{
+			auto head = _head.value.load(std::memory_order_relaxed);
+			if (head + n > _cachedTail)
+				_cachedTail = _tail.value.load(std::memory_order_acquire);
+			auto filled = _cachedTail - head;
+			Claim c = {head, n < filled ? n : filled};
+			return c;
+		}
+		void release(const Claim &c) { _head.value.store(c.first + c.count, std::memory_order_release); }
+
+	private:
+		static std::size_t roundUp(std::size_t n)
+		{
+			std::size_t p = 1;
+			while (p < n)
+				p <<= 1;
+			return p;
+		}
+		CacheAligned<t_slot> _slots;
+		std::size_t _mask;
+		PaddedIndex _head;
+		// producer local copy of _head
+		alignas(cacheLine) std::size_t _cachedHead;
+		PaddedIndex _tail;
+		// consumer local copy of _tail
+		alignas(cacheLine) std::size_t _cachedTail;
+	};
+	//------------------------------------------------------
+	/*
+	Multi producer, multi consumer ring (bounded queue after
+	D. Vyukov). Every slot carries a sequence number telling
+	whether it's free for position p (sequence == p) or
+	filled for it (sequence == p + 1). A batch claim checks
+	n slots first and then reserves them all with one CAS,
+	each slot is published individually on commit.
+	*/
+	//------------------------------------------------------
+	template <std::size_t SlotSize = 256>
+	class MpmcRing
+	{
+	public:
+		typedef Slot<SlotSize> t_slot;
+		/* capacity is rounded up to a power of two */
+		MpmcRing(std::size_t capacity) : _slots(roundUp(capacity)), _mask(_slots.size() - 1)
+		{
+			for (std::size_t i = 0; i < _slots.size(); ++i)
+				_slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+		std::size_t capacity() const { return _slots.size(); }
+		t_slot &slot(std::size_t index) { return _slots[index & _mask]; }
+		// producer side
+		Claim claim(std::size_t n) { return reserve(_enqueue, n, 0); }
+		void commit(const Claim &c)
+		{
+			for (std::size_t i = 0; i < c.count; ++i)
+				slot(c.first + i).sequence.store(c.first + i + 1, std::memory_order_release);
+		}
+		// consumer side
+		Claim take(std::size_t n) { return reserve(_dequeue, n, 1); }
+		void release(const Claim &c)
+		{
+			for (std::size_t i = 0; i < c.count; ++i)
+				slot(c.first + i).sequence.store(c.first + i + _slots.size(), std::memory_order_release);
+		}
+
+	private:
+		static std::size_t roundUp(std::size_t n)
+		{
+			std::size_t p = 1;
+			while (p < n)
+				p <<= 1;
+			return p;
+		}
+		/* reserve up to n slots whose sequence is position + lag, lag 0 for free and 1 for filled slots */
+		Claim reserve(PaddedIndex &index, std::size_t n, std::size_t lag)
+		{
+			auto pos = index.value.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				std::size_t ready = 0;
+				while (ready < n && slot(pos + ready).sequence.load(std::memory_order_acquire) == pos + ready + lag)
+					++ready;
+				if (0 == ready)
+				{
+					auto seq = slot(pos).sequence.load(std::memory_order_acquire);
+					if (static_cast<std::ptrdiff_t>(seq - (pos + lag)) < 0)
+					{
+						Claim none = {pos, 0};
+						return none; // full for producers, empty for consumers
+					}
+					pos = index.value.load(std::memory_order_relaxed);
+					continue;
+				}
+				if (index.value.compare_exchange_weak(pos, pos + ready, std::memory_order_relaxed))
+				{
+					Claim c = {pos, ready};
+					return c;
+				}
+			}
+		}
+		CacheAligned<t_slot> _slots;
+		std::size_t _mask;
+		PaddedIndex _enqueue;
+		PaddedIndex _dequeue;
+	};
+	//------------------------------------------------------
+	/*
+	Glue between the rings and the Messaging package.
+	post() serializes a message straight into a slot,
+	drain() decodes up to n messages in place and hands
+	them to onMessage(recieve::t_handle). A slot that fails
+	to decode (or whose handler throws) is skipped, the
+	others are still handed on, every taken slot is
+	released and the first exception is rethrown after.
+	*/
+	//------------------------------------------------------
+	template <typename Ring>
+	bool post(Ring &ring, Messaging::Send &sender, Messaging::Message &msg)
+	{
+		auto c = ring.claim(1);
+		if (0 == c.count)
+			return false;
+		auto &slot = ring.slot(c.first);
+		try
+		{
+			slot.length = static_cast<std::uint32_t>(sender.into(msg, slot.data, sizeof(slot.data)));
+		}
+		catch (...)
+		{
+			// the slot is claimed, it has to be committed, empty
+			slot.length = 0;
+			ring.commit(c);
+			throw;
+		}
+		ring.commit(c);
+		return true;
+	}
+	template <typename Ring, typename Handler>
+	std::size_t drain(Ring &ring, Messaging::recieve &receiver, Handler onMessage, std::size_t n = 64)
+	{
+		auto c = ring.take(n);
+		std::size_t messages = 0;
+		std::exception_ptr error;
+		for (std::size_t i = 0; i < c.count; ++i)
+		{
+			auto &slot = ring.slot(c.first + i);
+			if (0 == slot.length)
+				continue;
+			try
+			{
+				onMessage(receiver.package(slot.data, slot.length));
+				++messages;
+			}
+			catch (...)
+			{
+				if (!error)
+					error = std::current_exception();
+			}
+		}
+		// taken slots have to go back, an MpmcRing would stall and an SpscRing would read them again
+		ring.release(c);
+		if (error)
+			std::rethrow_exception(error);
+		return messages;
+	}
+	//------------------------------------------------------
+	/*
+	Multi-threaded receive pipeline. The thread calling
+	feed() splits the byte stream into frames, a pool of
+	work-stealing workers decodes and dispatches them in
+	parallel. Every worker owns a Factory of its own (so
+	its own pools) and its own recieve/InStream state, the
+	only shared state is the job queues.
+	With ordering on, frames with the same key (the message
+	id unless keyBy() says otherwise) run through a strand,
+	one at a time and in arrival order. A strand is stolen
+	as a whole, so ordering holds while stealing.
+	onMessage(Message &, worker) is called from all workers
+	concurrently and has to be thread-safe. The message
+	(and its view fields) is only valid during the call,
+	its handle stays with the worker and goes back to the
+	worker's pools right after, the pools aren't shared
+	between threads. Exceptions from onMessage don't count
+	as decode errors, the first is rethrown by wait().
+	Factory is a default constructible recieve::t_factory,
+	typically a Construction::Catalogue.
+	*/
+	//------------------------------------------------------
+	template <typename Factory>
+	class DecodePipeline
+	{
+	public:
+		typedef std::function<void(Messaging::Message &, std::size_t)> t_handler;
+		typedef std::function<std::size_t(const Messaging::Frame::Header &)> t_key;
+		DecodePipeline(std::size_t workers, t_handler onMessage, bool ordered = false,
+					   Serializer::WireFormat wireFormat = Serializer::WireFormat(), std::size_t strands = 64)
+			: _onMessage(onMessage), _ordered(ordered), _key(&byType), _roundRobin(0),
+			  _queued(0), _inflight(0), _messages(0), _errors(0), _stopping(false)
+		{
+			for (std::size_t i = 0; i < strands; ++i)
+				_strands.emplace_back(new Strand);
+			for (std::size_t i = 0; i < (workers ? workers : 1); ++i)
+				_workers.emplace_back(new Worker(wireFormat));
+			for (std::size_t i = 0; i < _workers.size(); ++i)
+				_workers[i]->thread = std::thread(&DecodePipeline::work, this, i);
+		}
+		~DecodePipeline() { stop(); }
+		DecodePipeline(const DecodePipeline &) = delete;
+		DecodePipeline &operator=(const DecodePipeline &) = delete;
+		/* ordering key of a frame, set it before the first feed() */
+		void keyBy(t_key key) { _key = key; }
+		/* split a chunk of the byte stream and queue its frames, the chunk is copied once */
+		void feed(const std::uint8_t *data, std::size_t size)
+		{
+			auto block = std::make_shared<Serializer::InStream::t_buffer>(data, data + size);
+			_splitter.feed(block->data(), block->size(), [this, &block](Serializer::ByteView frame) {
+				// a frame that straddled two chunks lives in the splitter, it needs a block of its own
+				if (frame.data() < block->data() || frame.data() >= block->data() + block->size())
+				{
+					auto own = std::make_shared<Serializer::InStream::t_buffer>(frame.begin(), frame.end());
+					submit(Job(own, own->data()));
+				}
+				else
+					submit(Job(block, frame.data()));
+			});
+		}
+		/* block until every frame fed so far is dispatched, rethrows the first exception of onMessage */
+		void wait()
+		{
+			idle();
+			rethrow();
+		}
+		/* wait() and stop the workers */
+		void finish()
+		{
+			stop();
+			rethrow();
+		}
+		std::size_t workers() const { return _workers.size(); }
+		std::size_t messages() const { return _messages.load(); }
+		/* frames that failed to decode */
+		std::size_t errors() const { return _errors.load(); }
+
+	private:
+		typedef std::shared_ptr<const Serializer::InStream::t_buffer> t_block;
+		static const std::size_t noStrand = ~std::size_t(0);
+		/* strands yield their worker after this many frames */
+		static const std::size_t strandBurst = 32;
+		struct Job
+		{
+			Job() : frame(nullptr), strand(noStrand) {}
+			Job(t_block b, const std::uint8_t *f) : block(b), frame(f), strand(noStrand) {}
+			explicit Job(std::size_t s) : frame(nullptr), strand(s) {}
+			t_block block;
+			const std::uint8_t *frame;
+			std::size_t strand;
+		};
+		struct Strand
+		{
+			Strand() : scheduled(false) {}
+			std::mutex lock;
+			std::deque<Job> jobs;
+			bool scheduled;
+		};
+		struct Worker
+		{
+			Worker(Serializer::WireFormat wireFormat) : receiver(factory, wireFormat) {}
+			std::mutex lock;
+			std::deque<Job> jobs;
+			Factory factory;
+			Messaging::recieve receiver;
+			std::vector<Messaging::recieve::t_handle> decoded;
+			std::thread thread;
+		};
+		static std::size_t byType(const Messaging::Frame::Header &h) { return h.type; }
+		void idle()
+		{
+			std::unique_lock<std::mutex> lk(_idleLock);
+			_idle.wait(lk, [this] { return 0 == _inflight.load(); });
+		}
+		void stop()
+		{
+			idle();
+			{
+				std::lock_guard<std::mutex> lk(_sleepLock);
+				_stopping = true;
+			}
+			_wake.notify_all();
+			for (auto &worker : _workers)
+				if (worker->thread.joinable())
+					worker->thread.join();
+		}
+		void rethrow()
+		{
+			std::exception_ptr failure;
+			{
+				std::lock_guard<std::mutex> lk(_failureLock);
+				std::swap(failure, _failure);
+			}
+			if (failure)
+				std::rethrow_exception(failure);
+		}
+		void submit(Job job)
+		{
+			++_inflight;
+			if (!_ordered)
+			{
+				push(std::move(job), _roundRobin++ % _workers.size());
+				return;
+			}
+			auto strand = _key(Messaging::Frame::read(job.frame)) % _strands.size();
+			auto &s = *_strands[strand];
+			bool schedule;
+			{
+				std::lock_guard<std::mutex> lk(s.lock);
+				s.jobs.push_back(std::move(job));
+				schedule = !s.scheduled;
+				s.scheduled = true;
+			}
+			if (schedule)
+				push(Job(strand), strand % _workers.size());
+		}
+		void push(Job job, std::size_t worker)
+		{
+			{
+				std::lock_guard<std::mutex> lk(_workers[worker]->lock);
+				_workers[worker]->jobs.push_back(std::move(job));
+			}
+			++_queued;
+			{
+				std::lock_guard<std::mutex> lk(_sleepLock);
+			}
+			_wake.notify_one();
+		}
+		/* own queue from the front, others' from the back */
+		bool pop(std::size_t worker, Job &job)
+		{
+			for (std::size_t i = 0; i < _workers.size(); ++i)
+			{
+				auto &victim = *_workers[(worker + i) % _workers.size()];
+				std::lock_guard<std::mutex> lk(victim.lock);
+				if (victim.jobs.empty())
+					continue;
+				if (0 == i)
+				{
+					job = std::move(victim.jobs.front());
+					victim.jobs.pop_front();
+				}
+				else
+				{
+					job = std::move(victim.jobs.back());
+					victim.jobs.pop_back();
+				}
+				--_queued;
+				return true;
+			}
+			return false;
+		}
+		void work(std::size_t worker)
+		{
+			for (;;)
+			{
+				Job job;
+				if (pop(worker, job))
+				{
+					run(worker, job);
+					continue;
+				}
+				std::unique_lock<std::mutex> lk(_sleepLock);
+				_wake.wait(lk, [this] { return _stopping || _queued.load() > 0; });
+				if (_stopping && 0 == _queued.load())
+					return;
+			}
+		}
+		void run(std::size_t worker, Job &job)
+		{
+			if (noStrand == job.strand)
+			{
+				decode(worker, job);
+				return;
+			}
+			auto &s = *_strands[job.strand];
+			for (std::size_t n = 0; n < strandBurst; ++n)
+			{
+				Job next;
+				{
+					std::lock_guard<std::mutex> lk(s.lock);
+					if (s.jobs.empty())
+					{
+						s.scheduled = false;
+						return;
+					}
+					next = std::move(s.jobs.front());
+					s.jobs.pop_front();
+				}
+				decode(worker, next);
+			}
+			// more frames left, back in line to stay fair to the other strands
+			push(std::move(job), worker);
+		}
+		void decode(std::size_t worker, Job &job)
+		{
+			auto &w = *_workers[worker];
+			auto onMessage = [&w](Messaging::recieve::t_handle msg) { w.decoded.push_back(std::move(msg)); };
+			try
+			{
+				auto h = Messaging::Frame::read(job.frame);
+				Messaging::decodeFrame(w.receiver, Serializer::ByteView(job.frame, Messaging::Frame::headerSize + h.length), onMessage);
+			}
+			catch (const std::exception &)
+			{
+				++_errors;
+			}
+			// the handler runs outside of the decoding, messages before a decode error are still handed on
+			for (auto &msg : w.decoded)
+			{
+				try
+				{
+					_onMessage(*msg, worker);
+					++_messages;
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lk(_failureLock);
+					if (!_failure)
+						_failure = std::current_exception();
+				}
+			}
+			// handles go back to this worker's pools, the block may go once nothing views it
+			w.decoded.clear();
+			job.block.reset();
+			if (0 == --_inflight)
+			{
+				std::lock_guard<std::mutex> lk(_idleLock);
+				_idle.notify_all();
+			}
+		}
+		t_handler _onMessage;
+		bool _ordered;
+		t_key _key;
+		std::size_t _roundRobin;
+		Messaging::FrameSplitter _splitter;
+		std::vector<std::unique_ptr<Strand>> _strands;
+		std::vector<std::unique_ptr<Worker>> _workers;
+		std::atomic<std::size_t> _queued;
+		std::atomic<std::size_t> _inflight;
+		std::atomic<std::size_t> _messages;
+		std::atomic<std::size_t> _errors;
+		bool _stopping;
+		std::mutex _sleepLock;
+		std::condition_variable _wake;
+		std::mutex _idleLock;
+		std::condition_variable _idle;
+		std::mutex _failureLock;
+		std::exception_ptr _failure;
+	};
+} // namespace Transport
+#if defined(__cpp_impl_coroutine) && defined(__linux__)
+/*
+	Async package, coroutine based receive from non-blocking
+	file descriptors (sockets, pipes) driven by epoll. One
+	EventLoop per thread serves any number of connections,
+	a coroutine per connection awaits decoded messages:
+		Async::Task serve(t_loop &loop, int fd)
+		{
+			t_loop::Connection connection(loop, fd);
+			while (auto msg = co_await connection.next())
+				...
+		}
+	Needs C++20 and Linux, the rest builds without it.
+*/
+namespace Async
+{
+	/* error handler of the loop running on this thread, null outside EventLoop::run() */
+	typedef std::function<void(std::exception_ptr)> t_errorHandler;
+	inline t_errorHandler *&currentErrorHandler()
+	{
+		thread_local t_errorHandler *handler = nullptr;
+		return handler;
+	}
+	//------------------------------------------------------
+	/*
+	Return type of a detached coroutine, it starts right
+	away and cleans up after itself when it returns. An
+	exception escaping it while a loop runs goes to that
+	loop's onError() handler, its locals (so its
+	Connection) are gone by then and the loop carries on.
+	Outside of run() it's rethrown to the caller.
+	*/
+	//------------------------------------------------------
+	struct Task
+	{
+		struct promise_type
+		{
+			Task get_return_object() { return Task(); }
+			std::suspend_never initial_suspend() noexcept { return {}; }
+			std::suspend_never final_suspend() noexcept { return {}; }
+			void return_void() {}
+			void unhandled_exception()
+			{
+				auto handler = currentErrorHandler();
+				if (nullptr == handler)
+					throw;
+				(*handler)(std::current_exception());
+			}
+		};
+	};
+	//------------------------------------------------------
+	/*
+	epoll event loop of one thread. Every fd is armed one
+	shot while a coroutine waits on it, so a connection
+	that has nothing to decode costs nothing and each
+	wake-up reads one chunk, busy connections can't starve
+	the others. The loop owns a Factory (so its own pools),
+	every connection its read buffer.
+	Everything but post() and stop() has to be called on
+	the loop's thread. To use more threads run a loop per
+	thread and hand connections to them with post().
+	Factory is a default constructible recieve::t_factory,
+	typically a Construction::Catalogue.
+	Destroying the loop ends every connection: coroutines
+	waiting in next() are resumed with end of stream, the
+	others find the connection closed when they get to it.
+	Handles of its messages have to be released before.
+	*/
+	//------------------------------------------------------
+	template <typename Factory>
+	class EventLoop
+	{
+	public:
+		class Connection;
+		EventLoop(Serializer::WireFormat wireFormat = Serializer::WireFormat())
+			: _epoll(::epoll_create1(EPOLL_CLOEXEC)), _wakeup(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+			  _wireFormat(wireFormat), _events(maxEvents), _batch(0), _pending(0), _stopping(false)
+		{
+			_onError = [](std::exception_ptr error) {
+				try
+				{
+					std::rethrow_exception(error);
+				}
+				catch (std::exception &e)
+				{
+					std::cerr << "coroutine failed in EventLoop: " << e.what() << std::endl;
+				}
+				catch (...)
+				{
+					std::cerr << "coroutine failed in EventLoop" << std::endl;
+				}
+			};
+			if (_epoll < 0 || _wakeup < 0)
+				throw std::runtime_error("can't create epoll/eventfd in EventLoop");
+			epoll_event ev = {};
+			ev.events = EPOLLIN;
+			ev.data.ptr = this;
+			if (0 != ::epoll_ctl(_epoll, EPOLL_CTL_ADD, _wakeup, &ev))
+				throw std::runtime_error("can't watch eventfd in EventLoop");
+		}
+		/* coroutines still waiting are resumed with end of stream, so they can finish */
+		~EventLoop()
+		{
+			ErrorScope scope(&_onError);
+			while (!_connections.empty())
+				(*_connections.begin())->detach();
+			::close(_wakeup);
+			::close(_epoll);
+		}
+		EventLoop(const EventLoop &) = delete;
+		EventLoop &operator=(const EventLoop &) = delete;
+		/* dispatch events until stop() */
+		void run()
+		{
+			ErrorScope scope(&_onError);
+			while (!_stopping.load())
+			{
+				auto n = ::epoll_wait(_epoll, _events.data(), static_cast<int>(_events.size()), -1);
+				if (n < 0 && EINTR != errno)
+					throw std::runtime_error("epoll_wait() failed in EventLoop");
+				_batch = _pending = n > 0 ? static_cast<std::size_t>(n) : 0;
+				for (; _pending > 0; --_pending)
+				{
+					auto &event = _events[_batch - _pending];
+					auto target = event.data.ptr;
+					event.data.ptr = nullptr;
+					if (this == target)
+						drain();
+					else if (nullptr != target)
+						static_cast<Connection *>(target)->ready();
+				}
+			}
+			_stopping = false;
+		}
+		/* thread-safe, job() runs on the loop's thread */
+		void post(std::function<void()> job)
+		{
+			{
+				std::lock_guard<std::mutex> lk(_postLock);
+				_posted.push_back(std::move(job));
+			}
+			wake();
+		}
+		/* thread-safe, run() returns after the current events */
+		void stop()
+		{
+			_stopping = true;
+			wake();
+		}
+		/* handler(std::exception_ptr) for exceptions escaping a Task, by default they're logged to std::cerr */
+		void onError(t_errorHandler handler) { _onError = handler; }
+		Factory &factory() { return _factory; }
+		std::size_t connections() const { return _connections.size(); }
+
+		//------------------------------------------------------
+		/*
+		A non-blocking fd read by the loop into a buffer of
+		the connection. next() hands out one message per
+		co_await and an empty handle once the peer has
+		closed the connection and everything has been handed
+		out. Frames are decoded one at a time, only when the
+		messages of the previous frame are handed out, and
+		the buffer is only refilled from within next(): view
+		fields of a message stay valid until the next
+		co_await next() on the same connection, copy them
+		out to keep them longer. Decode errors are rethrown
+		from the co_await after the messages before them.
+		The connection owns the fd and closes it.
+		*/
+		//------------------------------------------------------
+		class Connection
+		{
+		public:
+			Connection(EventLoop &loop, int fd)
+				: _loop(&loop), _fd(fd), _receiver(loop._factory, loop._wireFormat), _begin(0), _end(0), _registered(false), _closed(false)
+			{
+				auto flags = ::fcntl(fd, F_GETFL, 0);
+				if (flags < 0 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+					throw std::runtime_error("can't make fd non-blocking in Connection");
+				_loop->_connections.insert(this);
+			}
+			~Connection()
+			{
+				if (nullptr != _loop)
+				{
+					_loop->_connections.erase(this);
+					_loop->forget(this);
+				}
+				::close(_fd);
+			}
+			Connection(const Connection &) = delete;
+			Connection &operator=(const Connection &) = delete;
+			struct Next
+			{
+				Connection &connection;
+				bool await_ready()
+				{
+					if (connection._messages.empty() && !connection._closed)
+						connection.fill();
+					return !connection._messages.empty() || connection._closed;
+				}
+				void await_suspend(std::coroutine_handle<> waiter)
+				{
+					connection._waiter = waiter;
+					connection.arm();
+				}
+				Messaging::recieve::t_handle await_resume() { return connection.take(); }
+			};
+			/* co_await for the next message */
+			Next next() { return Next{*this}; }
+
+		private:
+			friend class EventLoop;
+			/* the next frame decoded, from the buffer or after reading a chunk, only while no message is queued */
+			void fill()
+			{
+				try
+				{
+					if (decode())
+						return;
+					auto n = read();
+					if (n > 0)
+						decode();
+					else if (0 == n)
+					{
+						if (_end != _begin)
+							throw std::runtime_error("connection closed in the middle of a frame");
+						_closed = true;
+					}
+				}
+				catch (...)
+				{
+					_error = std::current_exception();
+					_closed = true;
+				}
+			}
+			/* one chunk from the fd behind what's left, returns -1 if there's nothing to read now */
+			ssize_t read()
+			{
+				// nothing handed out points into the buffer anymore, the rest moves to the front
+				if (0 != _begin)
+				{
+					std::memmove(_buffer.data(), _buffer.data() + _begin, _end - _begin);
+					_end -= _begin;
+					_begin = 0;
+				}
+				auto want = std::max<std::size_t>(_end + 1, readChunk);
+				if (_end >= Messaging::Frame::headerSize)
+					want = std::max<std::size_t>(want, Messaging::Frame::headerSize + Messaging::Frame::read(_buffer.data()).length);
+				if (_buffer.size() < want)
+					_buffer.resize(want);
+				auto n = ::read(_fd, _buffer.data() + _end, _buffer.size() - _end);
+				if (n < 0 && (EAGAIN == errno || EWOULDBLOCK == errno || EINTR == errno))
+					return -1;
+				if (n < 0)
+					throw std::runtime_error("read() failed in Connection");
+				_end += static_cast<std::size_t>(n);
+				return n;
+			}
+			/* decodes the frame at the front of the buffer if it's complete */
+			bool decode()
+			{
+				auto left = _end - _begin;
+				if (left < Messaging::Frame::headerSize)
+					return false;
+				auto frame = Messaging::Frame::headerSize + Messaging::Frame::read(_buffer.data() + _begin).length;
+				if (left < frame)
+					return false;
+				auto onMessage = [this](Messaging::recieve::t_handle msg) { _messages.push_back(std::move(msg)); };
+				Messaging::decodeFrame(_receiver, Serializer::ByteView(_buffer.data() + _begin, frame), onMessage);
+				_begin += frame;
+				return true;
+			}
+			/* the fd became readable (or hung up) */
+			void ready()
+			{
+				fill();
+				if (_messages.empty() && !_closed)
+					return arm();
+				resume();
+			}
+			/* end of stream, the loop goes away, queued messages go back to its pools first */
+			void detach()
+			{
+				_loop->_connections.erase(this);
+				_loop = nullptr;
+				_messages.clear();
+				_error = nullptr;
+				_closed = true;
+				resume();
+			}
+			void resume()
+			{
+				auto waiter = _waiter;
+				_waiter = nullptr;
+				if (waiter)
+					waiter.resume();
+			}
+			void arm()
+			{
+				epoll_event ev = {};
+				ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+				ev.data.ptr = this;
+				if (0 != ::epoll_ctl(_loop->_epoll, _registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, _fd, &ev))
+				{
+					_error = std::make_exception_ptr(std::runtime_error("epoll_ctl() failed in Connection"));
+					_closed = true;
+					return resume();
+				}
+				_registered = true;
+			}
+			Messaging::recieve::t_handle take()
+			{
+				if (!_messages.empty())
+				{
+					auto msg = std::move(_messages.front());
+					_messages.pop_front();
+					return msg;
+				}
+				if (_error)
+					std::rethrow_exception(std::exchange(_error, nullptr));
+				return Messaging::recieve::t_handle();
+			}
+			EventLoop *_loop;
+			int _fd;
+			Messaging::recieve _receiver;
+			std::vector<std::uint8_t> _buffer;
+			std::size_t _begin;
+			std::size_t _end;
+			std::deque<Messaging::recieve::t_handle> _messages;
+			std::coroutine_handle<> _waiter;
+			std::exception_ptr _error;
+			bool _registered;
+			bool _closed;
+		};
+
+	private:
+		static constexpr std::size_t readChunk = 16 * 1024;
+		/* coroutines resumed by the loop report to its handler */
+		struct ErrorScope
+		{
+			ErrorScope(t_errorHandler *handler) : outer(currentErrorHandler()) { currentErrorHandler() = handler; }
+			~ErrorScope() { currentErrorHandler() = outer; }
+			t_errorHandler *outer;
+		};
+		static constexpr std::size_t maxEvents = 256;
+		/* called from other threads, a failed write means the counter is already set */
+		void wake() noexcept
+		{
+			std::uint64_t one = 1;
+			auto written = ::write(_wakeup, &one, sizeof(one));
+			(void)written;
+		}
+		/* eventfd fired: posted jobs */
+		void drain()
+		{
+			std::uint64_t count;
+			while (sizeof(count) == ::read(_wakeup, &count, sizeof(count)))
+				;
+			std::vector<std::function<void()>> jobs;
+			{
+				std::lock_guard<std::mutex> lk(_postLock);
+				jobs.swap(_posted);
+			}
+			for (auto &job : jobs)
+				job();
+		}
+		/* a connection that's gone must not get events still queued in this round */
+		void forget(Connection *c)
+		{
+			for (auto i = _batch - _pending; i < _batch; ++i)
+				if (c == _events[i].data.ptr)
+					_events[i].data.ptr = nullptr;
+		}
+		int _epoll;
+		int _wakeup;
+		Factory _factory;
+		Serializer::WireFormat _wireFormat;
+		std::vector<epoll_event> _events;
+		std::size_t _batch;
+		std::size_t _pending;
+		std::unordered_set<Connection *> _connections;
+		std::mutex _postLock;
+		std::vector<std::function<void()>> _posted;
+		std::atomic<bool> _stopping;
+		t_errorHandler _onError;
+	};
+} // namespace Async
+#endif
+/* test subject A*/
+class MyFirst : public Serializer::Serializable<MyFirst>
+{
+public:
+	typedef Serializer::Fields<std::uint8_t, std::uint8_t> fields;
+	MyFirst() : _val001(0), _val002(0){};
+	~MyFirst(){};
+	template <typename Stream>
+	void serialize(Stream &s)
+	{
+		s &_val001 &_val002;
+	}
+	void setPattern()
+	{
+		_val001 = 0x55;
+		_val002 = 0xAA;
+	}
+	void Tell(std::ostream &o)
+	{
+		TellLine(o, _val001, "_val001");
+		TellLine(o, _val002, "_val002");
+	}
+
+private:
+	inline void TellLine(std::ostream &o, std::uint8_t v, std::string name)
+	{
+		o << name.c_str() << "= " << std::hex << static_cast<std::uint16_t>(v) << std::endl;
+	}
+	std::uint8_t _val001;
+	std::uint8_t _val002;
+};
+/* test subject B*/
+class MySecond : public Serializer::Serializable<MySecond>
+{
+public:
+	typedef Serializer::Fields<MyFirst, std::uint8_t, std::uint8_t> fields;
+	MySecond() : _val003(0), _val004(0){};
+	~MySecond(){};
+	template <typename Stream>
+	void serialize(Stream &s)
+	{
+		s &_myFirst;
+		s &_val003 &_val004;
+	}
+	void setPattern()
+	{
+		_val003 = 0x99;
+		_val004 = 0x66;
+		_myFirst.setPattern();
+	}
+	void setVal003(std::uint8_t v) { _val003 = v; }
+	void Tell(std::ostream &o)
+	{
+		_myFirst.Tell(o);
+		TellLine(o, _val003, "_val003");
+		TellLine(o, _val004, "_val004");
+	}
+
+private:
+	inline void TellLine(std::ostream &o, std::uint8_t v, std::string name)
+	{
+		o << name.c_str() << "= " << std::hex << static_cast<std::uint16_t>(v) << std::endl;
+	}
+	std::uint8_t _val003;
+	std::uint8_t _val004;
+	MyFirst _myFirst;
+};
+/* test subject C, all the wider primitive types */
+class MyThird : public Serializer::Serializable<MyThird>
+{
+public:
+	MyThird() : _flag(false), _val005(0), _val006(0), _val007(0), _val008(0.0f), _val009(0.0){};
+	~MyThird(){};
+	template <typename Stream>
+	void serialize(Stream &s)
+	{
+		s &_flag &_val005 &_val006 &_val007;
+		s &_val008 &_val009;
+	}
+	void setPattern()
+	{
+		_flag = true;
+		_val005 = -0x1234;
+		_val006 = 0xDEADBEEF;
+		_val007 = -0x0123456789ABCDEF;
+		_val008 = 3.25f;
+		_val009 = -1.0 / 3.0;
+	}
+	void Tell(std::ostream &o)
+	{
+		o << "_flag= " << std::boolalpha << _flag << std::endl;
+		o << "_val005= " << std::dec << _val005 << std::endl;
+		o << "_val006= " << std::hex << _val006 << std::endl;
+		o << "_val007= " << std::dec << _val007 << std::endl;
+		o << "_val008= " << _val008 << std::endl;
+		o << "_val009= " << _val009 << std::endl;
+	}
+
+private:
+	bool _flag;
+	std::int16_t _val005;
+	std::uint32_t _val006;
+	std::int64_t _val007;
+	float _val008;
+	double _val009;
+};
+/* test subject D, a routing header in front of a body that's only decoded on access */
+class MyFourth : public Serializer::Serializable<MyFourth>
+{
+public:
+	MyFourth() : _route(0){};
+	~MyFourth(){};
+	template <typename Stream>
+	void serialize(Stream &s)
+	{
+		s &_route &_body;
+	}
+	void setPattern()
+	{
+		_route = 0x0102;
+		_body->setPattern();
+	}
+	std::uint16_t route() const { return _route; }
+	Serializer::Lazy<MyThird> &body() { return _body; }
+
+private:
+	std::uint16_t _route;
+	Serializer::Lazy<MyThird> _body;
+};
+/* test subject E, standard containers of primitives, text and objects */
+class MyFifth : public Serializer::Serializable<MyFifth>
+{
+public:
+	MyFifth() : _window(){};
+	~MyFifth(){};
+	template <typename Stream>
+	void serialize(Stream &s)
+	{
+		s &_samples &_name &_window &_labels &_parts;
+	}
+	void setPattern()
+	{
+		for (std::uint32_t i = 0; i < 100; ++i)
+			_samples.push_back(i * 0x01010101u);
+		_name = "goldies";
+		_window = {{1, 2, 0x0300, 0x0400}};
+		_labels[7] = "seven";
+		_labels[42] = "forty two";
+		_parts.resize(3);
+		_parts[1].setPattern();
+	}
+	std::size_t samples() const { return _samples.size(); }
+	std::size_t parts() const { return _parts.size(); }
+
+private:
+	std::vector<std::uint32_t> _samples;
+	std::string _name;
+	std::array<std::uint16_t, 4> _window;
+	std::map<std::uint32_t, std::string> _labels;
+	std::vector<MyThird> _parts;
+};
+/* test subject F, a topic and an opaque blob decoded as a view into the wire buffer */
+class MySixth : public Serializer::Serializable<MySixth>
+{
+public:
+	MySixth() : _topic(0){};
+	~MySixth(){};
+	template <typename Stream>
+	void serialize(Stream &s)
+	{
+		s &_topic &_blob;
+	}
+	void set(std::uint16_t topic, Serializer::ByteView blob)
+	{
+		_topic = topic;
+		_blob = blob;
+	}
+	std::uint16_t topic() const { return _topic; }
+	Serializer::ByteView blob() const { return _blob; }
+
+private:
+	std::uint16_t _topic;
+	Serializer::ByteView _blob;
+};
+/* test subject G, a marker without fields, takes no bytes in the compact format */
+class MySeventh : public Serializer::Serializable<MySeventh>
+{
+public:
+	typedef Serializer::Fields<> fields;
+	template <typename Stream>
+	void serialize(Stream &)
+	{
+	}
+};
+/* Concrete Creator for Message 001 */
+class Msg001ProductionLine : public Messaging::PooledProductionLine<MyFirst, Messaging::MessageIds::msg001>
+{
+} Msg001ProductionLineInstance;
+/* Concrete Creator */
+class Msg002ProductionLine : public Messaging::PooledProductionLine<MySecond, Messaging::MessageIds::msg002>
+{
+} Msg002ProductionLineInstance;
+/* Concrete Creator for Message 003, a payload with a view field */
+class Msg003ProductionLine : public Messaging::PooledProductionLine<MySixth, Messaging::MessageIds::msg003>
+{
+};
+
+#ifdef GOLDIES_BENCH
+//------------------------------------------------------
+/*
+	Benchmark build (make bench), replaces the sample's
+	main. Every operator new is counted, so allocations
+	per operation can be reported next to the timings.
+	Output is CSV, one line per case, the columns and
+	case names are kept stable so runs can be diffed.
+*/
+//------------------------------------------------------
+static std::atomic<std::size_t> g_allocations(0);
+void *operator new(std::size_t n)
+{
+	++g_allocations;
+	if (void *p = std::malloc(n ? n : 1))
+		return p;
+	throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+namespace Bench
+{
+	/* keeps the optimizer from dropping the measured work */
+	template <typename T>
+	inline void keep(const T &v)
+	{
+#if defined(_MSC_VER)
+		static volatile const void *sink;
+		sink = &v;
+#else
+		asm volatile("" : : "g"(&v) : "memory");
+#endif
+	}
+	/* synthetic subject, N levels of nesting with a field on each */
+	template <int N>
+	class Deep : public Serializer::Serializable<Deep<N>>
+	{
+	public:
+		Deep() : _level(N) {}
+		template <typename Stream>
+		void serialize(Stream &s)
+		{
+			s &_level &_inner;
 		}
 
 	private:
-		Serializer::OutStream _toOutput;
+		std::uint32_t _level;
+		Deep<N - 1> _inner;
 	};
-	//------------------------------------------------------
-	/*
-	Recieve class can reconstruct a message from a stream 
-	of bytes. This class utilizes the Construction package
-	to fabricate classes that knows serialization details
-	*/
-	//------------------------------------------------------
-	class recieve
+	template <>
+	class Deep<0> : public Serializer::Serializable<Deep<0>>
 	{
 	public:
-		typedef Construction::Factory<Message, MessageIds::type> t_factory;
-		/* Needs a factory to work with to reconstruct objects */
-		recieve(t_factory &factory) : _factory(factory) {}
-		/* turn byte stream back to message */
-		Message *package(Serializer::OutStream::t_buffer buf)
+		Deep() : _level(0) {}
+		template <typename Stream>
+		void serialize(Stream &s)
 		{
-			_input.setBuffer(buf);
-			auto id = static_cast<MessageIds::type>(_input.peek());
-			auto product = _factory.fabricate(id);
-			if (nullptr == product)
-				throw std::runtime_error("null ptr detected in package(Serializer::OutStream::t_buffer buf)!!");
-			product->serialize(_input);
-			return product;
+			s &_level;
 		}
 
 	private:
-		Serializer::InStream _input;
-		t_factory &_factory;
+		std::uint32_t _level;
 	};
-} // namespace Messaging
-/* test subject A*/
-class MyFirst : public Serializer::ISerializable
-{
-public:
-	MyFirst() : _val001(0), _val002(0){};
-	~MyFirst(){};
-	void serialize(Serializer::IStream &s) override
+	/* synthetic subject, 64 flat fields of mixed width */
+	class Wide : public Serializer::Serializable<Wide>
 	{
-		s &_val001 &_val002;
+	public:
+		Wide()
+		{
+			for (int i = 0; i < 16; ++i)
+			{
+				_a[i] = static_cast<std::uint8_t>(i);
+				_b[i] = static_cast<std::uint16_t>(i * 300);
+				_c[i] = static_cast<std::uint32_t>(i * 70000);
+				_d[i] = static_cast<std::uint64_t>(i) << 40;
+			}
+		}
+		template <typename Stream>
+		void serialize(Stream &s)
+		{
+			for (int i = 0; i < 16; ++i)
+				s &_a[i] &_b[i] &_c[i] &_d[i];
+		}
+
+	private:
+		std::uint8_t _a[16];
+		std::uint16_t _b[16];
+		std::uint32_t _c[16];
+		std::uint64_t _d[16];
+	};
+	/* synthetic subject, standard containers, decoding into it again doesn't allocate */
+	class Bulk : public Serializer::Serializable<Bulk>
+	{
+	public:
+		Bulk() : _samples(256), _text(64, 'g'), _parts(8)
+		{
+			for (std::uint32_t i = 0; i < _samples.size(); ++i)
+				_samples[i] = i * 0x01010101u;
+			for (std::uint32_t i = 0; i < 16; ++i)
+				_labels[i] = std::string(24, static_cast<char>('a' + i));
+		}
+		template <typename Stream>
+		void serialize(Stream &s)
+		{
+			s &_samples &_text &_labels &_parts;
+		}
+
+	private:
+		std::vector<std::uint32_t> _samples;
+		std::string _text;
+		std::map<std::uint32_t, std::string> _labels;
+		std::vector<Deep<0>> _parts;
+	};
+	/* synthetic subject, a 4KB blob held as a ByteView or as an owning vector */
+	template <typename Field>
+	class Blob : public Serializer::Serializable<Blob<Field>>
+	{
+	public:
+		Blob() : _blob(source()) {}
+		template <typename Stream>
+		void serialize(Stream &s)
+		{
+			s &_blob;
+		}
+
+	private:
+		static const std::vector<std::uint8_t> &source()
+		{
+			static const std::vector<std::uint8_t> bytes(4096, 0x5a);
+			return bytes;
+		}
+		Field _blob;
+	};
+	/* runs op until the timing is stable and prints one CSV line, bytes and messages are what one op() call handles,
+	   wire is what those bytes take after compression, 0 if they aren't compressed */
+	template <typename Op>
+	void run(const char *name, const char *variant, std::size_t bytes, std::size_t messages, Op op, std::size_t wire = 0)
+	{
+		typedef std::chrono::steady_clock clock;
+		const auto target = std::chrono::milliseconds(50);
+		for (int i = 0; i < 100; ++i)
+			op(); // warm up pools and caches
+		std::size_t iterations = 1000;
+		for (;;)
+		{
+			auto allocations = g_allocations.load();
+			auto start = clock::now();
+			for (std::size_t i = 0; i < iterations; ++i)
+				op();
+			auto elapsed = clock::now() - start;
+			allocations = g_allocations.load() - allocations;
+			if (elapsed >= target || iterations >= (std::size_t(1) << 30))
+			{
+				double ns = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+				std::printf("%s,%s,%.2f,%zu,%.0f,%.3f,%zu\n", name, variant, ns, bytes,
+							ns > 0 ? 1e9 * messages / ns : 0.0, static_cast<double>(allocations) / iterations, 0 < wire ? wire : bytes);
+				return;
+			}
+			iterations *= 2;
+		}
 	}
-	void setPattern()
+	/* encode and decode of one subject type in one wire format, static and virtual paths */
+	template <typename T>
+	void codec(const char *name, const char *variant, Serializer::WireFormat wireFormat)
 	{
-		_val001 = 0x55;
-		_val002 = 0xAA;
+		T subject;
+		Serializer::OutStream out(wireFormat);
+		out &subject;
+		auto encoded = out.getbuffer();
+		std::string label(name);
+		run((label + ".encode").c_str(), variant, encoded.size(), 1, [&] {
+			out.reset();
+			out &subject;
+			keep(out.data());
+		});
+		run((label + ".encode.virtual").c_str(), variant, encoded.size(), 1, [&] {
+			out.reset();
+			static_cast<Serializer::ISerializable &>(subject).serialize(out);
+			keep(out.data());
+		});
+		std::vector<std::uint8_t> slot(encoded.size());
+		run((label + ".encode.attached").c_str(), variant, encoded.size(), 1, [&] {
+			out.attach(slot.data(), slot.size());
+			out &subject;
+			out.detach();
+			keep(slot[0]);
+		});
+		run((label + ".decode").c_str(), variant, encoded.size(), 1, [&] {
+			Serializer::InStream in(encoded, wireFormat);
+			in &subject;
+			keep(subject);
+		});
+		run((label + ".decode.virtual").c_str(), variant, encoded.size(), 1, [&] {
+			Serializer::InStream in(encoded, wireFormat);
+			static_cast<Serializer::ISerializable &>(subject).serialize(in);
+			keep(subject);
+		});
+		run((label + ".measure").c_str(), variant, encoded.size(), 1, [&] {
+			keep(Serializer::measure(subject, wireFormat));
+		});
 	}
-	void Tell(std::ostream &o)
+	/* delta of an unchanged object against its baseline, the steady state of state replication */
+	template <typename T>
+	void delta(const char *name, const char *variant, Serializer::WireFormat wireFormat)
 	{
-		TellLine(o, _val001, "_val001");
-		TellLine(o, _val002, "_val002");
+		T subject, replica;
+		Serializer::DeltaOutStream encoder(wireFormat);
+		Serializer::DeltaInStream applier(wireFormat);
+		encoder.rebase(subject);
+		auto encoded = encoder.encode(subject);
+		std::string label(name);
+		run((label + ".delta.encode").c_str(), variant, encoded.size(), 1, [&] {
+			keep(encoder.encode(subject).data());
+		});
+		run((label + ".delta.apply").c_str(), variant, encoded.size(), 1, [&] {
+			keep(applier.apply(encoded, replica));
+		});
 	}
-
-private:
-	inline void TellLine(std::ostream &o, std::uint8_t v, std::string name)
+	/* Send/recieve/Factory/Dispatcher round trips for one message in one wire format */
+	template <typename Payload>
+	void messaging(const char *name, Messaging::MessageIds::type id, const char *variant, Serializer::WireFormat wireFormat)
 	{
-		o << name.c_str() << "= " << std::hex << static_cast<std::uint16_t>(v) << std::endl;
+		typedef Construction::Catalogue<Messaging::Message, Messaging::MessageIds::type, Msg001ProductionLine, Msg002ProductionLine> t_catalogue;
+		t_catalogue factory;
+		Payload payload;
+		payload.setPattern();
+		Messaging::Message msg(id, &payload);
+		Messaging::Send sender(wireFormat);
+		Messaging::recieve receiver(factory, wireFormat);
+		auto wire = sender.package(msg);
+		std::string label(name);
+		run((label + ".send.package").c_str(), variant, wire.size(), 1, [&] {
+			keep(sender.package(msg).data());
+		});
+		run((label + ".recieve.package").c_str(), variant, wire.size(), 1, [&] {
+			auto handle = receiver.package(wire);
+			keep(handle);
+		});
+		run((label + ".factory.order").c_str(), variant, 0, 1, [&] {
+			auto handle = factory.order(id);
+			keep(handle);
+		});
+		run((label + ".factory.fabricate").c_str(), variant, 0, 1, [&] {
+			auto product = factory.fabricate(id);
+			keep(product);
+			if (id == Messaging::MessageIds::msg001)
+				factory.line<Msg001ProductionLine>().Recycle(product);
+			else
+				factory.line<Msg002ProductionLine>().Recycle(product);
+		});
+		Messaging::Dispatcher dispatcher(wireFormat);
+		dispatcher.on<Payload>(id, [](Payload &p) { keep(p); });
+		run((label + ".dispatcher.dispatch").c_str(), variant, wire.size(), 1, [&] {
+			dispatcher.dispatch(wire);
+		});
+		const std::size_t batchSize = 64;
+		std::vector<Messaging::Message *> outgoing(batchSize, &msg);
+		auto batch = sender.batch(outgoing.begin(), outgoing.end());
+		run((label + ".send.batch64").c_str(), variant, batch.size(), batchSize, [&] {
+			keep(sender.batch(outgoing.begin(), outgoing.end()).data());
+		});
+		Messaging::FrameDecoder decoder(receiver);
+		run((label + ".framedecoder.batch64").c_str(), variant, batch.size(), batchSize, [&] {
+			decoder.feed(batch.data(), batch.size(), [](Messaging::recieve::t_handle handle) { keep(handle); });
+		});
 	}
-	std::uint8_t _val001;
-	std::uint8_t _val002;
-};
-/* test subject B*/
-class MySecond : public Serializer::ISerializable
-{
-public:
-	MySecond() : _val003(0), _val004(0){};
-	~MySecond(){};
-	void serialize(Serializer::IStream &s) override
+	/* a stream of framed messages through a DecodePipeline, per message id ordering */
+	template <typename Payload>
+	void pipeline(const char *name, Messaging::MessageIds::type id, std::size_t workers, const char *variant, Serializer::WireFormat wireFormat)
 	{
-		s &_myFirst;
-		s &_val003 &_val004;
+		typedef Construction::Catalogue<Messaging::Message, Messaging::MessageIds::type, Msg001ProductionLine, Msg002ProductionLine> t_catalogue;
+		const std::size_t messages = 1024;
+		Payload payload;
+		payload.setPattern();
+		Messaging::Message msg(id, &payload);
+		Messaging::Send sender(wireFormat);
+		Serializer::OutStream::t_buffer stream;
+		for (std::size_t i = 0; i < messages; ++i)
+		{
+			auto &frame = sender.frame(msg);
+			stream.insert(stream.end(), frame.begin(), frame.end());
+		}
+		Transport::DecodePipeline<t_catalogue> decoder(workers, [](Messaging::Message &m, std::size_t) { keep(m); }, true, wireFormat);
+		std::string label(name);
+		run((label + ".pipeline.x" + std::to_string(workers)).c_str(), variant, stream.size(), messages, [&] {
+			decoder.feed(stream.data(), stream.size());
+			decoder.wait();
+		});
 	}
-	void setPattern()
+	/* LZ block codec on a batch of messages, bytes_per_op is the uncompressed batch every row goes through,
+	   wire_bytes_per_op what it's compressed to */
+	void compression(const char *name, Messaging::Message &msg, std::size_t messages, const char *variant, Serializer::WireFormat wireFormat)
 	{
-		_val003 = 0x99;
-		_val004 = 0x66;
-		_myFirst.setPattern();
+		Messaging::Send sender(wireFormat);
+		std::vector<Messaging::Message *> outgoing(messages, &msg);
+		auto batch = sender.batch(outgoing.begin(), outgoing.end());
+		Compression::Lz lz;
+		std::vector<std::uint8_t> compressed(Compression::Lz::bound(batch.size())), restored(batch.size());
+		auto size = lz.compress(batch.data(), batch.size(), compressed.data(), compressed.size());
+		std::string label(name);
+		run((label + ".lz.compress").c_str(), variant, batch.size(), messages, [&] {
+			keep(lz.compress(batch.data(), batch.size(), compressed.data(), compressed.size()));
+		}, size);
+		run((label + ".lz.decompress").c_str(), variant, batch.size(), messages, [&] {
+			keep(Compression::Lz::decompress(compressed.data(), size, restored.data(), restored.size()));
+		}, size);
+		sender.compressAbove(0);
+		auto frameSize = sender.batch(outgoing.begin(), outgoing.end()).size();
+		run((label + ".send.batch.lz").c_str(), variant, batch.size(), messages, [&] {
+			keep(sender.batch(outgoing.begin(), outgoing.end()).data());
+		}, frameSize);
 	}
-	void Tell(std::ostream &o)
+	/* one frame with a big view field, copied by frame() or referenced by gather() */
+	void gathering(const char *name, std::size_t blobSize, const char *variant, Serializer::WireFormat wireFormat)
 	{
-		_myFirst.Tell(o);
-		TellLine(o, _val003, "_val003");
-		TellLine(o, _val004, "_val004");
+		std::vector<std::uint8_t> blob(blobSize, 0x5a);
+		MySixth payload;
+		payload.set(0x0600, blob);
+		Messaging::Message msg(Messaging::MessageIds::msg003, &payload);
+		Messaging::Send sender(wireFormat);
+		auto size = sender.frame(msg).size();
+		std::string label(name);
+		run((label + ".send.frame").c_str(), variant, size, 1, [&] {
+			keep(sender.frame(msg).data());
+		});
+		run((label + ".send.gather").c_str(), variant, size, 1, [&] {
+			keep(sender.gather(msg).data());
+		});
 	}
-
-private:
-	inline void TellLine(std::ostream &o, std::uint8_t v, std::string name)
+	int main()
 	{
-		o << name.c_str() << "= " << std::hex << static_cast<std::uint16_t>(v) << std::endl;
+		Serializer::WireFormat tagged;
+		Serializer::WireFormat compact(Serializer::WireFormat::compact);
+		auto varint = Serializer::WireFormat(Serializer::WireFormat::compact).withVarints();
+		const struct
+		{
+			const char *name;
+			Serializer::WireFormat format;
+		} formats[] = {{"tagged", tagged}, {"compact", compact}, {"varint", varint}};
+		std::printf("case,variant,ns_per_op,bytes_per_op,msgs_per_s,allocs_per_op,wire_bytes_per_op\n");
+		for (auto &f : formats)
+		{
+			codec<MyFirst>("MyFirst", f.name, f.format);
+			codec<MySecond>("MySecond", f.name, f.format);
+			codec<Deep<16>>("Deep16", f.name, f.format);
+			codec<Wide>("Wide64", f.name, f.format);
+			codec<Bulk>("Bulk", f.name, f.format);
+			codec<Blob<std::vector<std::uint8_t>>>("Blob4k.copy", f.name, f.format);
+			codec<Blob<Serializer::ByteView>>("Blob4k.view", f.name, f.format);
+			delta<MySecond>("MySecond", f.name, f.format);
+			delta<Wide>("Wide64", f.name, f.format);
+			messaging<MyFirst>("Msg001", Messaging::MessageIds::msg001, f.name, f.format);
+			messaging<MySecond>("Msg002", Messaging::MessageIds::msg002, f.name, f.format);
+			pipeline<MySecond>("Msg002x1024", Messaging::MessageIds::msg002, 1, f.name, f.format);
+			pipeline<MySecond>("Msg002x1024", Messaging::MessageIds::msg002, 4, f.name, f.format);
+			MyFirst first;
+			MySecond second;
+			first.setPattern();
+			second.setPattern();
+			Messaging::Message msg001(Messaging::MessageIds::msg001, &first), msg002(Messaging::MessageIds::msg002, &second);
+			compression("Msg001x1024", msg001, 1024, f.name, f.format);
+			compression("Msg002x1024", msg002, 1024, f.name, f.format);
+			gathering("Blob64k", 64 * 1024, f.name, f.format);
+		}
+		return 0;
 	}
-	std::uint8_t _val003;
-	std::uint8_t _val004;
-	MyFirst _myFirst;
-};
-/* Concrete Creator for Message 001 */
-class Msg001ProductionLine : public Construction::IProduce<Messaging::Message>
+} // namespace Bench
+int main()
 {
-public:
-	typedef Construction::IProduce<Messaging::Message>::productPtr productPtr;
-	productPtr Create() override
+	return Bench::main();
+}
+#else
+#if defined(__cpp_impl_coroutine) && defined(__linux__)
+/* one coroutine per connection for the async receive test, the last one stops the loop */
+template <typename Loop>
+Async::Task countMessages(Loop &loop, int fd, std::size_t &received, std::size_t &open)
+{
+	typename Loop::Connection connection(loop, fd);
+	while (auto msg = co_await connection.next())
+		++received;
+	if (0 == --open)
+		loop.stop();
+}
+/* resumes the coroutine from the loop's queue, the other connections run in between */
+template <typename Loop>
+struct Yield
+{
+	Loop &loop;
+	bool await_ready() { return false; }
+	void await_suspend(std::coroutine_handle<> waiter)
 	{
-		return new Messaging::Message(Messaging::MessageIds::msg001, new MyFirst);
+		loop.post([waiter] { waiter.resume(); });
 	}
-	Messaging::MessageIds::type getId() { return Messaging::MessageIds::msg001; }
-} Msg001ProductionLineInstance;
-/* Concrete Creator */
-class Msg002ProductionLine : public Construction::IProduce<Messaging::Message>
+	void await_resume() {}
+};
+/* hands its handle to parked and waits to be resumed by hand, then reads what's left */
+template <typename Loop>
+Async::Task parkThenDrain(Loop &loop, int fd, std::coroutine_handle<> &parked, std::size_t &received)
 {
-public:
-	typedef Construction::IProduce<Messaging::Message>::productPtr productPtr;
-	productPtr Create() override
+	struct Park
+	{
+		std::coroutine_handle<> &parked;
+		bool await_ready() { return false; }
+		void await_suspend(std::coroutine_handle<> waiter) { parked = waiter; }
+		void await_resume() {}
+	};
+	typename Loop::Connection connection(loop, fd);
+	co_await Park{parked};
+	while (auto msg = co_await connection.next())
+		++received;
+}
+/* reads blobs of the byte tag, checking each view after the other connections had their turn */
+template <typename Loop>
+Async::Task checkViews(Loop &loop, int fd, std::uint8_t tag, std::size_t &intact, std::size_t &open)
+{
+	typename Loop::Connection connection(loop, fd);
+	while (auto msg = co_await connection.next())
 	{
-		return new Messaging::Message(Messaging::MessageIds::msg002, new MySecond);
+		co_await Yield<Loop>{loop};
+		auto blob = dynamic_cast<MySixth &>(msg->getPayload()).blob();
+		if (std::all_of(blob.begin(), blob.end(), [tag](std::uint8_t b) { return b == tag; }))
+			++intact;
 	}
-	Messaging::MessageIds::type getId() { return Messaging::MessageIds::msg002; }
-} Msg002ProductionLineInstance;
-
+	if (0 == --open)
+		loop.stop();
+}
+#endif
 /* bringing everything together :-) */
 int main()
 {
@@ -418,20 +5166,782 @@ int main()
 		// does it match our intented payload?
 		instanceOfMyFirst.Tell(std::cout);
 
-		auto wireformatedMessage = ToNodeB.package(Msg001Instance);
+		auto &wireformatedMessage = ToNodeB.package(Msg001Instance);
 
 		// over the wire ........ magic
 
 		// Node B
 		Messaging::recieve FromNodeA(MsgFactory);
-		// deserialization and fabrication bundled into one....
-		auto MessageForMe = FromNodeA.package(wireformatedMessage);
+		// deserialization and fabrication bundled into one, decoded in place from the sender's buffer....
+		auto MessageForMe = FromNodeA.package(wireformatedMessage.data(), wireformatedMessage.size());
 
 		// print out the reassembled class, does it again match our original data?
 		dynamic_cast<MyFirst &>(MessageForMe->getPayload()).Tell(std::cout);
+
+		std::cout << "compact wire format test" << std::endl;
+		// same message without the TV tags, with and without the schema hash in the header
+		Serializer::WireFormat compact(Serializer::WireFormat::compact);
+		auto checked = Serializer::WireFormat(Serializer::WireFormat::compact).withSchemaCheck();
+		Messaging::Send CompactToNodeB(compact), CheckedToNodeB(checked);
+		auto &compactMessage = CompactToNodeB.package(Msg001Instance);
+		auto &checkedMessage = CheckedToNodeB.package(Msg001Instance);
+		std::cout << "tagged " << std::dec << wireformatedMessage.size() << " bytes, compact "
+				  << compactMessage.size() << " bytes, compact + schema " << checkedMessage.size() << " bytes" << std::endl;
+		Messaging::recieve CheckedFromNodeA(MsgFactory, checked);
+		auto CompactMessageForMe = CheckedFromNodeA.package(checkedMessage);
+		dynamic_cast<MyFirst &>(CompactMessageForMe->getPayload()).Tell(std::cout);
+
+		std::cout << "framing test" << std::endl;
+		// two framed messages back to back on one byte stream
+		MySecond instanceOfMySecond;
+		instanceOfMySecond.setPattern();
+		Messaging::Message Msg002Instance(Messaging::MessageIds::msg002, &instanceOfMySecond);
+		Serializer::OutStream::t_buffer stream(ToNodeB.frame(Msg001Instance));
+		auto &secondFrame = ToNodeB.frame(Msg002Instance);
+		stream.insert(stream.end(), secondFrame.begin(), secondFrame.end());
+		Messaging::recieve StreamFromNodeA(MsgFactory);
+		Messaging::FrameDecoder decoder(StreamFromNodeA);
+		auto onMessage = [](Messaging::recieve::t_handle msg) {
+			if (Messaging::MessageIds::msg001 == msg->getId())
+				dynamic_cast<MyFirst &>(msg->getPayload()).Tell(std::cout);
+			else
+				dynamic_cast<MySecond &>(msg->getPayload()).Tell(std::cout);
+		};
+#if defined(__unix__) || defined(__APPLE__)
+		// over a local socket, read back in small arbitrary chunks
+		int sockets[2];
+		if (0 != socketpair(AF_UNIX, SOCK_STREAM, 0, sockets))
+			throw std::runtime_error("socketpair() failed");
+		if (write(sockets[0], stream.data(), stream.size()) != static_cast<ssize_t>(stream.size()))
+			throw std::runtime_error("write() failed");
+		close(sockets[0]);
+		std::uint8_t chunk[5];
+		ssize_t got;
+		while ((got = read(sockets[1], chunk, sizeof(chunk))) > 0)
+			decoder.feed(chunk, static_cast<std::size_t>(got), onMessage);
+		close(sockets[1]);
+#else
+		for (std::size_t at = 0; at < stream.size(); at += 5)
+			decoder.feed(stream.data() + at, std::min<std::size_t>(5, stream.size() - at), onMessage);
+#endif
+
+		{
+			// an unknown message id between two good frames costs that frame only
+			Serializer::OutStream::t_buffer mixed(ToNodeB.frame(Msg001Instance));
+			auto bad = mixed;
+			bad[Messaging::Frame::headerSize + 1] = 0xEE; // the id behind its tag
+			mixed.insert(mixed.end(), bad.begin(), bad.end());
+			mixed.insert(mixed.end(), secondFrame.begin(), secondFrame.end());
+			Messaging::FrameDecoder checking(StreamFromNodeA);
+			std::size_t delivered = 0, errors = 0;
+			auto count = [&delivered](Messaging::recieve::t_handle) { ++delivered; };
+			try
+			{
+				checking.feed(mixed.data(), mixed.size(), count);
+			}
+			catch (std::runtime_error &)
+			{
+				++errors;
+			}
+			std::cout << "in one chunk " << std::dec << delivered << " of 3 frames delivered, " << errors << " error";
+			delivered = errors = 0;
+			for (auto &byte : mixed)
+			{
+				try
+				{
+					checking.feed(&byte, 1, count);
+				}
+				catch (std::runtime_error &)
+				{
+					++errors;
+				}
+			}
+			std::cout << ", byte by byte " << delivered << " of 3, " << errors << " error" << std::endl;
+#ifdef GOLDIES_METRICS
+			// an empty message is corrupt traffic as well, it has to show up in the counters
+			auto errorsBefore = Metrics::snapshot().decodeErrors;
+			try
+			{
+				StreamFromNodeA.package(Serializer::ByteView());
+			}
+			catch (std::runtime_error &)
+			{
+			}
+			std::cout << "empty message counted as " << Metrics::snapshot().decodeErrors - errorsBefore << " decode error" << std::endl;
+#endif
+			// a frame no receiver would take isn't sent at all
+			std::vector<std::uint8_t> huge(Messaging::Frame::maxLength + 1);
+			MySixth oversized;
+			oversized.set(0x0600, huge);
+			Messaging::Message hugeMsg(Messaging::MessageIds::msg003, &oversized);
+			std::vector<Messaging::Message *> hugeBatch(1, &hugeMsg);
+			Messaging::Send sending;
+			std::size_t refused = 0;
+			for (int how = 0; how < 3; ++how)
+			{
+				try
+				{
+					if (0 == how)
+						sending.frame(hugeMsg);
+					else if (1 == how)
+						sending.gather(hugeMsg);
+					else
+						sending.batch(hugeBatch.begin(), hugeBatch.end());
+				}
+				catch (std::runtime_error &)
+				{
+					++refused;
+				}
+			}
+			std::cout << refused << " of 3 oversized frames refused by the sender" << std::endl;
+		}
+
+		std::cout << "scatter-gather test" << std::endl;
+		{
+			// a big blob is sent from where it is, the rest is coalesced around it
+			std::vector<std::uint8_t> blob(64 * 1024);
+			for (std::size_t i = 0; i < blob.size(); ++i)
+				blob[i] = static_cast<std::uint8_t>(i >> 3);
+			MySixth sixth;
+			sixth.set(0x0600, blob);
+			Messaging::Message msg(Messaging::MessageIds::msg003, &sixth);
+			Messaging::Send sender;
+			auto &segments = sender.gather(msg);
+			std::vector<std::uint8_t> joined;
+			for (auto &segment : segments)
+				joined.insert(joined.end(), segment.begin(), segment.end());
+			auto referenced = segments.size() > 1 && segments[1].data() == blob.data();
+			std::cout << std::dec << segments.size() << " segments, blob " << (referenced ? "referenced" : "COPIED") << ", "
+					  << (joined == sender.frame(msg) ? "same as frame()" : "DIFFERENT");
+#if defined(__unix__) || defined(__APPLE__)
+			int sockets[2];
+			if (0 != socketpair(AF_UNIX, SOCK_STREAM, 0, sockets))
+				throw std::runtime_error("socketpair() failed");
+			std::size_t written = 0;
+			std::thread writer([&] {
+				written = sender.writev(sockets[0], msg);
+				close(sockets[0]);
+			});
+			std::vector<std::uint8_t> wire, chunk(4096);
+			ssize_t got;
+			while ((got = read(sockets[1], chunk.data(), chunk.size())) > 0)
+				wire.insert(wire.end(), chunk.data(), chunk.data() + got);
+			writer.join();
+			close(sockets[1]);
+			std::cout << ", writev " << written << " bytes " << (wire == joined ? "identical" : "DIFFERENT");
+#endif
+			std::cout << std::endl;
+			// gather() and frame() agree in every wire format, also with a Lazy body kept as it was read
+			auto prefixed = Serializer::WireFormat().withLengthPrefix();
+			MyFourth fourth, routed;
+			fourth.setPattern();
+			Serializer::OutStream encoded(prefixed);
+			encoded &fourth;
+			Serializer::InStream input(encoded.getbuffer(), prefixed);
+			input &routed;
+			const struct
+			{
+				const char *name;
+				Serializer::WireFormat format;
+			} formats[] = {{"prefixed", prefixed},
+						   {"compact", Serializer::WireFormat(Serializer::WireFormat::compact)},
+						   {"varint", Serializer::WireFormat(Serializer::WireFormat::compact).withVarints()}};
+			Messaging::Message lazy(Messaging::MessageIds::msg001, &routed);
+			for (auto &f : formats)
+			{
+				Messaging::Send formatted(f.format);
+				std::cout << f.name;
+				for (auto m : {&msg, &lazy})
+				{
+					joined.clear();
+					for (auto &segment : formatted.gather(*m))
+						joined.insert(joined.end(), segment.begin(), segment.end());
+					std::cout << (m == &lazy ? ", lazy " : " blob ") << (joined == formatted.frame(*m) ? "same as frame()" : "DIFFERENT");
+				}
+				std::cout << ", body decoded " << std::boolalpha << routed.body().decoded() << std::endl;
+			}
+		}
+
+		std::cout << "batch test" << std::endl;
+		// many messages packed into one frame, decoded in a single pass
+		std::vector<Messaging::Message *> outgoing(100, &Msg001Instance);
+		outgoing.push_back(&Msg002Instance);
+		auto &batchFrame = ToNodeB.batch(outgoing.begin(), outgoing.end());
+		std::size_t received = 0, fed = decoder.feed(batchFrame.data(), batchFrame.size(), [&received](Messaging::recieve::t_handle) { ++received; });
+		std::cout << std::dec << fed << " messages in one " << batchFrame.size() << " byte frame, "
+				  << received << " handled" << std::endl;
+
+		std::cout << "compression test" << std::endl;
+		// big frames LZ compressed, small ones bypass it
+		Messaging::Send CompressedToNodeB;
+		CompressedToNodeB.compressAbove(256);
+		std::vector<Messaging::Message *> repeated(1000, &Msg002Instance);
+		auto &compressedBatch = CompressedToNodeB.batch(repeated.begin(), repeated.end());
+		std::cout << std::dec << repeated.size() << " messages in one " << compressedBatch.size() << " byte frame, compressed "
+				  << std::boolalpha << (0 != (compressedBatch[5] & Messaging::Frame::compressed));
+		received = decoder.feed(compressedBatch.data(), compressedBatch.size(), [](Messaging::recieve::t_handle) {});
+		auto &smallFrame = CompressedToNodeB.frame(Msg002Instance);
+		std::cout << ", " << received << " handled, single " << smallFrame.size() << " byte frame, compressed "
+				  << (0 != (smallFrame[5] & Messaging::Frame::compressed)) << std::endl;
+
+		std::cout << "catalogue test" << std::endl;
+		// factory built from a type list, ids checked at compile time, flat table lookup
+		Construction::Catalogue<Messaging::Message, Messaging::MessageIds::type, Msg001ProductionLine, Msg002ProductionLine> catalogue;
+		Messaging::recieve FromCatalogue(catalogue);
+		auto CataloguedMessage = FromCatalogue.package(ToNodeB.package(Msg001Instance));
+		dynamic_cast<MyFirst &>(CataloguedMessage->getPayload()).Tell(std::cout);
+
+		std::cout << "dispatcher test" << std::endl;
+		// decoded into handler owned payloads, typed callbacks, no casts
+		Messaging::Dispatcher dispatcher;
+		dispatcher.on<MyFirst>(Messaging::MessageIds::msg001, [](MyFirst &first) { first.Tell(std::cout); });
+		dispatcher.on<MySecond>(Messaging::MessageIds::msg002, [](MySecond &second) { second.Tell(std::cout); });
+		dispatcher.dispatch(ToNodeB.package(Msg001Instance));
+		dispatcher.dispatch(ToNodeB.package(Msg002Instance));
+	}
+
+	std::cout << "ring buffer test" << std::endl;
+	{
+		Construction::Factory<Messaging::Message, Messaging::MessageIds::type> MsgFactory;
+		MsgFactory.install(Msg001ProductionLineInstance.getId(), &Msg001ProductionLineInstance);
+		const std::size_t total = 100000;
+		// producers serialize straight into ring slots
+		auto produce = [total](Transport::MpmcRing<> &ring, std::size_t count) {
+			Messaging::Send sender;
+			MyFirst payload;
+			payload.setPattern();
+			Messaging::Message msg(Messaging::MessageIds::msg001, &payload);
+			for (std::size_t i = 0; i < count; ++i)
+				while (!Transport::post(ring, sender, msg))
+					std::this_thread::yield();
+		};
+		Transport::MpmcRing<> ring(1024);
+		std::thread producerA(produce, std::ref(ring), total / 2), producerB(produce, std::ref(ring), total - total / 2);
+		// and the consumer decodes in place from them, in batches
+		Messaging::recieve FromRing(MsgFactory);
+		std::size_t received = 0, matching = 0;
+		auto onMessage = [&matching](Messaging::recieve::t_handle msg) {
+			if (Messaging::MessageIds::msg001 == msg->getId())
+				++matching;
+		};
+		while (received < total)
+		{
+			auto n = Transport::drain(ring, FromRing, onMessage);
+			if (0 == n)
+				std::this_thread::yield();
+			received += n;
+		}
+		producerA.join();
+		producerB.join();
+		std::cout << std::dec << received << " messages through the ring, " << matching << " intact" << std::endl;
+
+		// one producer, one consumer, with a corrupt slot half way
+		Transport::SpscRing<> spsc(256);
+		std::thread producer([&spsc, total] {
+			Messaging::Send sender;
+			MyFirst payload;
+			payload.setPattern();
+			Messaging::Message msg(Messaging::MessageIds::msg001, &payload);
+			for (std::size_t i = 0; i < total; ++i)
+			{
+				if (total / 2 == i)
+				{
+					Transport::Claim c;
+					while (0 == (c = spsc.claim(1)).count)
+						std::this_thread::yield();
+					auto &slot = spsc.slot(c.first);
+					slot.data[0] = 0x7F; // no such message id
+					slot.length = 1;
+					spsc.commit(c);
+				}
+				while (!Transport::post(spsc, sender, msg))
+					std::this_thread::yield();
+			}
+		});
+		std::size_t failures = 0;
+		matching = 0;
+		while (matching < total)
+		{
+			try
+			{
+				if (0 == Transport::drain(spsc, FromRing, onMessage))
+					std::this_thread::yield();
+			}
+			catch (std::runtime_error &)
+			{
+				++failures;
+			}
+		}
+		producer.join();
+		std::cout << matching << " messages through the single producer ring, " << failures << " corrupt slot skipped" << std::endl;
+	}
+
+	std::cout << "decode pipeline test" << std::endl;
+	{
+		// a framed byte stream of 10000 messages, cut into 1000 byte chunks
+		MyFirst first;
+		MySecond second;
+		first.setPattern();
+		second.setPattern();
+		Messaging::Message Msg001Instance(Messaging::MessageIds::msg001, &first), Msg002Instance(Messaging::MessageIds::msg002, &second);
+		Messaging::Send ToPipeline;
+		Serializer::OutStream::t_buffer stream;
+		for (int i = 0; i < 5000; ++i)
+		{
+			auto &a = ToPipeline.frame(Msg001Instance);
+			stream.insert(stream.end(), a.begin(), a.end());
+			auto &b = ToPipeline.frame(Msg002Instance);
+			stream.insert(stream.end(), b.begin(), b.end());
+		}
+		// every worker has its own catalogue, so its own pools, per message id ordering
+		typedef Construction::Catalogue<Messaging::Message, Messaging::MessageIds::type, Msg001ProductionLine, Msg002ProductionLine> t_catalogue;
+		std::atomic<std::size_t> intact(0);
+		Transport::DecodePipeline<t_catalogue> pipeline(4, [&intact](Messaging::Message &, std::size_t) {
+			++intact;
+		}, true);
+		for (std::size_t at = 0; at < stream.size(); at += 1000)
+			pipeline.feed(stream.data() + at, std::min<std::size_t>(1000, stream.size() - at));
+		pipeline.finish();
+		std::cout << std::dec << pipeline.messages() << " messages decoded by " << pipeline.workers() << " workers, "
+				  << intact.load() << " intact, " << pipeline.errors() << " errors" << std::endl;
+
+		// 8 keys of numbered messages, every key has to come out in the order it went in
+		const std::size_t keys = 8, perKey = 2000;
+		stream.clear();
+		MySixth numbered;
+		Messaging::Message Msg003Instance(Messaging::MessageIds::msg003, &numbered);
+		std::vector<std::uint8_t> pad(keys);
+		for (std::size_t i = 0; i < keys * perKey; ++i)
+		{
+			// the key shows in the frame length, the blob is as long as the key
+			numbered.set(static_cast<std::uint16_t>(i), Serializer::ByteView(pad.data(), i % keys));
+			auto &frame = ToPipeline.frame(Msg003Instance);
+			stream.insert(stream.end(), frame.begin(), frame.end());
+		}
+		typedef Construction::Catalogue<Messaging::Message, Messaging::MessageIds::type, Msg003ProductionLine> t_numberedCatalogue;
+		std::vector<std::size_t> next(keys);
+		std::atomic<std::size_t> outOfOrder(0);
+		Transport::DecodePipeline<t_numberedCatalogue> ordered(4, [&](Messaging::Message &msg, std::size_t) {
+			// a strand runs on one worker at a time, the counter of a key is never touched concurrently
+			auto &payload = dynamic_cast<MySixth &>(msg.getPayload());
+			auto key = payload.blob().size();
+			if (payload.topic() != next[key]++ * keys + key)
+				++outOfOrder;
+		}, true);
+		ordered.keyBy([](const Messaging::Frame::Header &h) { return static_cast<std::size_t>(h.length); });
+		for (std::size_t at = 0; at < stream.size(); at += 1000)
+			ordered.feed(stream.data() + at, std::min<std::size_t>(1000, stream.size() - at));
+		ordered.finish();
+		std::cout << ordered.messages() << " numbered messages, " << outOfOrder.load() << " out of order";
+
+		// a failing handler isn't a decode error, finish() rethrows it
+		Transport::DecodePipeline<t_numberedCatalogue> failing(2, [](Messaging::Message &, std::size_t) {
+			throw std::logic_error("handler failed");
+		});
+		failing.feed(stream.data(), stream.size());
+		try
+		{
+			failing.finish();
+			std::cout << ", handler failure LOST" << std::endl;
+		}
+		catch (std::logic_error &e)
+		{
+			std::cout << ", " << e.what() << " rethrown, " << failing.errors() << " decode errors" << std::endl;
+		}
+	}
+
+#if defined(__cpp_impl_coroutine) && defined(__linux__)
+	std::cout << "async receive test" << std::endl;
+	{
+		// 200 socket connections served by coroutines on this thread
+		typedef Construction::Catalogue<Messaging::Message, Messaging::MessageIds::type, Msg001ProductionLine, Msg002ProductionLine> t_catalogue;
+		MyFirst first;
+		MySecond second;
+		first.setPattern();
+		second.setPattern();
+		Messaging::Message Msg001Instance(Messaging::MessageIds::msg001, &first), Msg002Instance(Messaging::MessageIds::msg002, &second);
+		Messaging::Send ToLoop;
+		Serializer::OutStream::t_buffer stream;
+		for (int i = 0; i < 50; ++i)
+		{
+			auto &a = ToLoop.frame(Msg001Instance);
+			stream.insert(stream.end(), a.begin(), a.end());
+			auto &b = ToLoop.frame(Msg002Instance);
+			stream.insert(stream.end(), b.begin(), b.end());
+		}
+		Async::EventLoop<t_catalogue> loop;
+		std::vector<int> peers;
+		std::size_t received = 0, open = 200;
+		for (std::size_t i = 0; i < open; ++i)
+		{
+			int sockets[2];
+			if (0 != socketpair(AF_UNIX, SOCK_STREAM, 0, sockets))
+				throw std::runtime_error("socketpair() failed");
+			peers.push_back(sockets[0]);
+			countMessages(loop, sockets[1], received, open);
+		}
+		// the peers write in two parts, cut in the middle of a frame
+		std::thread writer([&stream, &peers] {
+			for (auto part : {std::size_t(0), std::size_t(1)})
+				for (auto peer : peers)
+				{
+					auto half = stream.size() / 2 + 3;
+					auto from = part ? half : 0, to = part ? stream.size() : half;
+					if (write(peer, stream.data() + from, to - from) != static_cast<ssize_t>(to - from))
+						throw std::runtime_error("write() failed");
+					if (part)
+						close(peer);
+				}
+		});
+		loop.run();
+		writer.join();
+		std::cout << std::dec << received << " messages over " << peers.size() << " connections on one thread" << std::endl;
+
+		// view fields point into the buffer of their connection, the other one reads in between
+		typedef Construction::Catalogue<Messaging::Message, Messaging::MessageIds::type, Msg003ProductionLine> t_viewCatalogue;
+		Async::EventLoop<t_viewCatalogue> viewLoop;
+		std::size_t intact = 0, viewsOpen = 2;
+		for (std::uint8_t tag = 1; tag <= 2; ++tag)
+		{
+			int sockets[2];
+			if (0 != socketpair(AF_UNIX, SOCK_STREAM, 0, sockets))
+				throw std::runtime_error("socketpair() failed");
+			std::vector<std::uint8_t> blob(2000, tag);
+			MySixth sixth;
+			sixth.set(tag, blob);
+			Messaging::Message msg(Messaging::MessageIds::msg003, &sixth);
+			for (int i = 0; i < 3; ++i)
+			{
+				auto &frame = ToLoop.frame(msg);
+				if (write(sockets[0], frame.data(), frame.size()) != static_cast<ssize_t>(frame.size()))
+					throw std::runtime_error("write() failed");
+			}
+			close(sockets[0]);
+			checkViews(viewLoop, sockets[1], tag, intact, viewsOpen);
+		}
+		// a peer sending garbage only ends its own coroutine, the loop reports it and carries on
+		std::size_t failed = 0;
+		viewLoop.onError([&](std::exception_ptr) {
+			++failed;
+			if (0 == --viewsOpen)
+				viewLoop.stop();
+		});
+		{
+			int sockets[2];
+			if (0 != socketpair(AF_UNIX, SOCK_STREAM, 0, sockets))
+				throw std::runtime_error("socketpair() failed");
+			const std::uint8_t garbage[] = {1, 0, 0, 0, 0x7F, 0, 0x7F};
+			if (write(sockets[0], garbage, sizeof(garbage)) != static_cast<ssize_t>(sizeof(garbage)))
+				throw std::runtime_error("write() failed");
+			close(sockets[0]);
+			// started from the loop, outside of run() the exception would go to the caller
+			++viewsOpen;
+			auto fd = sockets[1];
+			viewLoop.post([&, fd] { checkViews(viewLoop, fd, 3, intact, viewsOpen); });
+		}
+		viewLoop.run();
+		std::cout << intact << " of 6 views intact over 2 connections, " << failed << " failed connection reported" << std::endl;
+
+		// a coroutine suspended elsewhere when its loop goes away finds its connection closed later
+		std::coroutine_handle<> parked;
+		std::size_t afterLoop = 0;
+		{
+			Async::EventLoop<t_viewCatalogue> shortLived;
+			int sockets[2];
+			if (0 != socketpair(AF_UNIX, SOCK_STREAM, 0, sockets))
+				throw std::runtime_error("socketpair() failed");
+			close(sockets[0]);
+			parkThenDrain(shortLived, sockets[1], parked, afterLoop);
+		}
+		parked.resume();
+		std::cout << "parked coroutine finished after its loop, " << afterLoop << " messages" << std::endl;
+	}
+
+#endif
+	std::cout << "parallel snapshot test" << std::endl;
+	{
+		std::vector<MySecond> originals(100000), copies(100000), fromChunks(100000);
+		for (auto &original : originals)
+			original.setPattern();
+		auto snapshot = Serializer::parallelSerialize(originals.begin(), originals.end(), 4);
+		auto stitched = snapshot.stitch();
+		Serializer::parallelDeserialize(stitched, snapshot.index, copies.begin(), copies.end(), 4);
+		Serializer::parallelDeserialize(snapshot, fromChunks.begin(), fromChunks.end());
+		// serialized once more, all three have to be identical
+		Serializer::OutStream copied, chunked;
+		for (auto &copy : copies)
+			copied &copy;
+		for (auto &copy : fromChunks)
+			chunked &copy;
+		std::cout << std::dec << originals.size() << " objects in " << snapshot.chunks.size() << " chunks, "
+				  << stitched.size() << " bytes, " << (copied.getbuffer() == stitched && chunked.getbuffer() == stitched ? "identical" : "DIFFERENT") << std::endl;
+		// a truncated buffer and a truncated chunk decoded on worker threads throw on the caller's thread
+		std::size_t rejected = 0;
+		stitched.resize(stitched.size() / 2);
+		try
+		{
+			Serializer::parallelDeserialize(stitched, snapshot.index, copies.begin(), copies.end(), 4);
+		}
+		catch (std::runtime_error &)
+		{
+			++rejected;
+		}
+		snapshot.chunks[1].resize(snapshot.chunks[1].size() - 1);
+		try
+		{
+			Serializer::parallelDeserialize(snapshot, fromChunks.begin(), fromChunks.end());
+		}
+		catch (std::runtime_error &)
+		{
+			++rejected;
+		}
+		std::cout << rejected << " of 2 truncated snapshots rejected" << std::endl;
+	}
+
+	std::cout << "archive test" << std::endl;
+	{
+		const char *path = "goldies.archive";
+		std::vector<MySecond> originals(100000);
+		for (auto &original : originals)
+			original.setPattern();
+		{
+			Serializer::ArchiveWriter writer(path, Serializer::WireFormat(Serializer::WireFormat::compact));
+			writer.append(Serializer::parallelSerialize(originals.begin(), originals.end(), 4, Serializer::WireFormat(Serializer::WireFormat::compact)));
+			MyFirst extra;
+			writer.append(extra);
+		}
+		{
+			Serializer::ArchiveReader reader(path);
+			auto last = reader.get<MySecond>(originals.size() - 1);
+			Serializer::OutStream expected(reader.wireFormat()), loaded(reader.wireFormat());
+			expected &originals.back();
+			loaded &last;
+			std::cout << std::dec << reader.size() << " objects, object " << originals.size() - 1 << " is "
+					  << reader.at(originals.size() - 1).size() << " bytes, "
+					  << (expected.getbuffer() == loaded.getbuffer() ? "identical" : "DIFFERENT") << std::endl;
+		}
+		std::remove(path);
+	}
+
+	std::cout << "lazy nested test" << std::endl;
+	{
+		auto prefixed = Serializer::WireFormat().withLengthPrefix();
+		MyFourth original;
+		original.setPattern();
+		Serializer::OutStream output(prefixed);
+		output &original;
+		// a router reads the header only and forwards the body as it is
+		MyFourth routed;
+		Serializer::InStream input(output.getbuffer(), prefixed);
+		input &routed;
+		std::cout << "route " << std::hex << routed.route() << ", body decoded " << std::boolalpha << routed.body().decoded();
+		Serializer::OutStream forwarded(prefixed);
+		forwarded &routed;
+		std::cout << ", forwarded " << (forwarded.getbuffer() == output.getbuffer() ? "identical" : "DIFFERENT");
+		Serializer::InStream skipping(output.getbuffer(), prefixed);
+		skipping.skip();
+		std::cout << ", skipped " << std::dec << skipping.consumed() << " of " << output.size() << " bytes" << std::endl;
+		// through the virtual interface, and into delta streams that need the fields
+		MyFourth virtualRouted;
+		Serializer::InStream again(output.getbuffer(), prefixed);
+		static_cast<Serializer::IStream &>(again) & virtualRouted;
+		Serializer::OutStream virtualForwarded(prefixed);
+		static_cast<Serializer::IStream &>(virtualForwarded) & virtualRouted;
+		std::cout << "virtual forward " << (virtualForwarded.getbuffer() == output.getbuffer() ? "identical" : "DIFFERENT")
+				  << ", body decoded " << virtualRouted.body().decoded();
+		MyFourth replica;
+		Serializer::DeltaOutStream encoder;
+		Serializer::DeltaInStream applier;
+		encoder.rebase(replica);
+		auto changed = applier.apply(encoder.encode(virtualRouted), replica);
+		Serializer::OutStream replicated(prefixed);
+		replicated &replica;
+		std::cout << ", delta " << std::dec << changed << " of " << encoder.fields() << " fields, replica "
+				  << (replicated.getbuffer() == output.getbuffer() ? "identical" : "DIFFERENT") << std::endl;
+		routed.body()->Tell(std::cout);
+		// without length prefixes the body is decoded while reading
+		const struct
+		{
+			const char *name;
+			Serializer::WireFormat format;
+		} unprefixed[] = {{"tagged", Serializer::WireFormat()},
+						  {"compact", Serializer::WireFormat(Serializer::WireFormat::compact)},
+						  {"varint", Serializer::WireFormat(Serializer::WireFormat::compact).withVarints()}};
+		for (auto &f : unprefixed)
+		{
+			MyFourth copy;
+			Serializer::OutStream written(f.format), rewritten(f.format);
+			written &original;
+			Serializer::InStream read(written.getbuffer(), f.format);
+			read &copy;
+			rewritten &copy;
+			std::cout << f.name << " round trip " << (rewritten.getbuffer() == written.getbuffer() && read.remaining() == 0 ? "identical" : "DIFFERENT")
+					  << ", body decoded " << copy.body().decoded() << std::endl;
+		}
+	}
+
+	std::cout << "delta test" << std::endl;
+	{
+		MySecond sent, replica;
+		Serializer::DeltaOutStream encoder;
+		Serializer::DeltaInStream applier;
+		encoder.rebase(sent);
+		sent.setPattern();
+		auto changed = applier.apply(encoder.encode(sent), replica);
+		std::cout << "first delta " << std::dec << changed << " of " << encoder.fields() << " fields";
+		sent.setVal003(0x42);
+		auto &delta = encoder.encode(sent);
+		changed = applier.apply(delta, replica);
+		std::cout << ", then " << changed << " field in " << delta.size() << " bytes (full " << Serializer::measure(sent) << ")";
+		std::cout << ", unchanged " << encoder.encode(sent).size() << " bytes";
+		Serializer::OutStream expected, applied;
+		expected &sent;
+		applied &replica;
+		std::cout << ", replica " << (expected.getbuffer() == applied.getbuffer() ? "identical" : "DIFFERENT");
+		// a field count of 2^64-1 with no bitmap behind it
+		std::vector<std::uint8_t> corrupt(10, 0xFF);
+		corrupt.back() = 0x01;
+		try
+		{
+			applier.apply(corrupt, replica);
+			std::cout << ", corrupt delta ACCEPTED" << std::endl;
+		}
+		catch (std::runtime_error &e)
+		{
+			std::cout << ", corrupt delta rejected: " << e.what() << std::endl;
+		}
+	}
+
+	std::cout << "container test" << std::endl;
+	{
+		MyFifth original, copy;
+		original.setPattern();
+		const struct
+		{
+			const char *name;
+			Serializer::WireFormat format;
+		} formats[] = {{"tagged", Serializer::WireFormat()},
+					   {"compact", Serializer::WireFormat(Serializer::WireFormat::compact)},
+					   {"varint", Serializer::WireFormat(Serializer::WireFormat::compact).withVarints()},
+					   {"prefixed", Serializer::WireFormat().withLengthPrefix()}};
+		for (auto &f : formats)
+		{
+			Serializer::OutStream output(f.format), again(f.format);
+			original.serialize(output);
+			// twice into the same object, the second decode reuses what the first allocated
+			for (int i = 0; i < 2; ++i)
+			{
+				Serializer::InStream input(output.getbuffer(), f.format);
+				copy.serialize(input);
+			}
+			copy.serialize(again);
+			std::cout << f.name << " " << std::dec << output.size() << " bytes, measured " << Serializer::measure(original, f.format)
+					  << ", " << copy.samples() << " samples " << copy.parts() << " parts, "
+					  << (again.getbuffer() == output.getbuffer() ? "identical" : "DIFFERENT") << std::endl;
+		}
+		// elements that take no bytes can't bound the length, ones with a fields list do
+		Serializer::WireFormat compact(Serializer::WireFormat::compact);
+		std::vector<MySeventh> markers(1000), markersCopy;
+		Serializer::OutStream markersOutput(compact);
+		markersOutput &markers;
+		Serializer::InStream markersInput(markersOutput.getbuffer(), compact);
+		markersInput &markersCopy;
+		std::vector<MyFirst> firsts(3), firstsCopy;
+		Serializer::OutStream firstsOutput(compact);
+		firstsOutput &firsts;
+		auto corrupt = firstsOutput.getbuffer();
+		corrupt[0] = 4; // 4 elements of at least 2 bytes in 6
+		std::cout << std::dec << markersCopy.size() << " empty elements in " << markersOutput.size() << " bytes";
+		try
+		{
+			Serializer::InStream corruptInput(corrupt, compact);
+			corruptInput &firstsCopy;
+			std::cout << ", corrupt length ACCEPTED" << std::endl;
+		}
+		catch (std::runtime_error &e)
+		{
+			std::cout << ", corrupt length rejected: " << e.what() << std::endl;
+		}
+		MyFifth empty;
+		std::cout << "schema " << (Serializer::schemaOf(original) == Serializer::schemaOf(empty) ? "independent of the content" : "DIFFERS") << std::endl;
+	}
+
+	std::cout << "view field test" << std::endl;
+	{
+		std::vector<std::uint8_t> blob(4096);
+		for (std::size_t i = 0; i < blob.size(); ++i)
+			blob[i] = static_cast<std::uint8_t>(i * 7);
+		MySixth original, received;
+		original.set(0x0600, blob);
+		Serializer::OutStream output;
+		output &original;
+		Serializer::InStream input(output.getbuffer());
+		input &received;
+		auto inPlace = received.blob().data() >= output.data() && received.blob().end() <= output.data() + output.size();
+		std::cout << "topic " << std::hex << received.topic() << ", " << std::dec << received.blob().size() << " bytes "
+				  << (inPlace ? "in the wire buffer" : "COPIED") << ", byte 3 is " << int(received.blob().data()[3]);
+		// forwarded as it was received
+		Serializer::OutStream forwarded;
+		forwarded &received;
+		std::cout << ", forwarded " << (forwarded.getbuffer() == output.getbuffer() ? "identical" : "DIFFERENT");
+		// the owning type reads the same bytes
+		std::uint16_t topic;
+		std::vector<std::uint8_t> owned;
+		Serializer::InStream owning(output.getbuffer());
+		owning &topic &owned;
+		std::cout << ", as vector " << (owned == blob ? "identical" : "DIFFERENT") << std::endl;
+	}
+
+	std::cout << "primitive types test" << std::endl;
+	{
+		MyThird original, copy;
+		original.setPattern();
+		Serializer::OutStream output;
+		original.serialize(output);
+		Serializer::InStream input(output.getbuffer());
+		copy.serialize(input);
+		original.Tell(std::cout);
+		copy.Tell(std::cout);
+
+		std::cout << "measure test" << std::endl;
+		static_assert(Serializer::fixedSize<MySecond>(Serializer::WireFormat::tagged) == 8, "MySecond holds four tagged bytes");
+		MySecond second;
+		Serializer::OutStream secondOutput;
+		second.serialize(secondOutput);
+		std::cout << "measured " << std::dec << Serializer::measure(original) << " == written " << output.size()
+				  << ", constexpr " << Serializer::FixedSize<MySecond>::tagged << " == written " << secondOutput.size();
+		if (!Serializer::fixedSizeMatches<MyFirst>() || !Serializer::fixedSizeMatches<MySecond>())
+			throw std::logic_error("a fields list doesn't match its serialize()");
+		std::cout << ", fields lists match serialize()" << std::endl;
+
+		std::cout << "varint test" << std::endl;
+		Serializer::WireFormat fixedFormat(Serializer::WireFormat::compact);
+		auto varintFormat = Serializer::WireFormat(Serializer::WireFormat::compact).withVarints();
+		Serializer::OutStream fixedOutput(fixedFormat), varintOutput(varintFormat);
+		original.serialize(fixedOutput);
+		original.serialize(varintOutput);
+		std::cout << "fixed " << std::dec << fixedOutput.size() << " bytes, varint " << varintOutput.size() << " bytes" << std::endl;
+		MyThird fromVarint;
+		Serializer::InStream varintInput(varintOutput.getbuffer(), varintFormat);
+		fromVarint.serialize(varintInput);
+		fromVarint.Tell(std::cout);
+		// 2^63 is the longest encoding, a 10th byte above 1 doesn't fit 64 bits
+		std::uint8_t largest[Serializer::Varint::maxBytes] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01};
+		std::uint8_t overlong[Serializer::Varint::maxBytes] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x03};
+		std::uint64_t decoded = 0;
+		auto used = Serializer::Varint::decode(largest, largest + sizeof(largest), decoded);
+		std::cout << "2^63 in " << std::dec << used << " bytes " << (decoded == std::uint64_t(1) << 63 ? "decoded" : "WRONG");
+		std::cout << ", overlong " << (0 == Serializer::Varint::decode(overlong, overlong + sizeof(overlong), decoded) ? "rejected" : "ACCEPTED") << std::endl;
 	}
+#ifdef GOLDIES_METRICS
+	std::cout << "metrics" << std::endl;
+	auto metrics = Metrics::snapshot();
+	metrics.writeText(std::cout);
+	metrics.writeJson(std::cout);
+#endif
 
 	getchar();
 
 	return 0;
 }
+#endif // GOLDIES_BENCH